@@ -44,6 +44,10 @@ android {
     buildFeatures {
         viewBinding = true
     }
+    androidResources {
+        // The native code maps the model straight from the APK, which needs it stored uncompressed
+        noCompress += "tflite"
+    }
 }
 
 dependencies {
@@ -0,0 +1,184 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BackgroundBlur.h"
+
+#include <algorithm>
+#include <string>
+
+static constexpr float kDefaultStrength = 1.0f;
+
+BackgroundBlur::BackgroundBlur()
+        : m_frameDownProgram(0),
+          m_downProgram(0),
+          m_upProgram(0),
+          m_frameDownHalfTexel(-1),
+          m_downHalfTexel(-1),
+          m_upHalfTexel(-1),
+          m_strength(kDefaultStrength),
+          m_quarter{{0, 0}, 0, 0},
+          m_eighth{{0, 0}, 0, 0} {
+}
+
+BackgroundBlur::~BackgroundBlur() {
+    if (m_frameDownProgram != 0) {
+        DeleteProgram(m_frameDownProgram);
+    }
+
+    if (m_downProgram != 0) {
+        DeleteProgram(m_downProgram);
+    }
+
+    if (m_upProgram != 0) {
+        DeleteProgram(m_upProgram);
+    }
+}
+
+auto BackgroundBlur::Initialize() -> void {
+    std::string flipVertexShaderCode = "#define FLIP_Y\n";
+    flipVertexShaderCode += VertexShaderCode();
+    m_frameDownProgram = CreateProgram(flipVertexShaderCode.c_str(),
+                                       FragmentDownsampleShaderCode());
+    m_frameDownHalfTexel = glGetUniformLocation(m_frameDownProgram, "uHalfTexel");
+
+    m_downProgram = CreateProgram(VertexShaderCode(), FragmentDownsampleShaderCode());
+    m_downHalfTexel = glGetUniformLocation(m_downProgram, "uHalfTexel");
+
+    m_upProgram = CreateProgram(VertexShaderCode(), FragmentUpsampleShaderCode());
+    m_upHalfTexel = glGetUniformLocation(m_upProgram, "uHalfTexel");
+}
+
+auto BackgroundBlur::Allocate(GLTexturePool &pool, int32_t width, int32_t height) -> void {
+    Release(pool);
+
+    m_quarter.width = std::max((width + 3) / 4, 1);
+    m_quarter.height = std::max((height + 3) / 4, 1);
+    m_quarter.target = pool.Acquire(m_quarter.width, m_quarter.height, GL_RGB, GL_LINEAR, true);
+
+    m_eighth.width = std::max((m_quarter.width + 1) / 2, 1);
+    m_eighth.height = std::max((m_quarter.height + 1) / 2, 1);
+    m_eighth.target = pool.Acquire(m_eighth.width, m_eighth.height, GL_RGB, GL_LINEAR, true);
+
+    SetOffsets();
+}
+
+auto BackgroundBlur::Release(GLTexturePool &pool) -> void {
+    pool.Release(m_quarter.target);
+    pool.Release(m_eighth.target);
+}
+
+auto BackgroundBlur::SetStrength(float strength) -> void {
+    m_strength = strength;
+    if (m_quarter.target.texture != 0) {
+        SetOffsets();
+    }
+}
+
+auto BackgroundBlur::SetOffsets() const -> void {
+    const auto setHalfTexel = [this](GLuint program, GLint location, const Level &level) {
+        GLState::Instance().UseProgram(program);
+        glUniform2f(location, 0.5f * m_strength / static_cast<GLfloat>(level.width),
+                    0.5f * m_strength / static_cast<GLfloat>(level.height));
+    };
+
+    // Offsets are half texels of the level rendered into, which is one texel of the source
+    // level for a 2x downsample and two frame texels for the 4x first pass
+    setHalfTexel(m_frameDownProgram, m_frameDownHalfTexel, m_quarter);
+    setHalfTexel(m_downProgram, m_downHalfTexel, m_eighth);
+    setHalfTexel(m_upProgram, m_upHalfTexel, m_quarter);
+}
+
+auto BackgroundBlur::Apply(GLuint vertexBuffer, GLuint frameTexture) const -> GLuint {
+    Pass("BlurDown/4", vertexBuffer, m_frameDownProgram, frameTexture, m_quarter);
+    Pass("BlurDown/8", vertexBuffer, m_downProgram, m_quarter.target.texture, m_eighth);
+    Pass("BlurUp/4", vertexBuffer, m_upProgram, m_eighth.target.texture, m_quarter);
+
+    return m_quarter.target.texture;
+}
+
+auto BackgroundBlur::Pass(const char *name, GLuint vertexBuffer, GLuint program, GLuint source,
+                          const Level &level) const -> void {
+    GL_PASS(name);
+
+    auto &state = GLState::Instance();
+    state.Viewport(0, 0, level.width, level.height);
+    state.BindFramebuffer(level.target.framebuffer);
+    state.BindTexture(0, GL_TEXTURE_2D, source);
+    state.UseProgram(program);
+
+    state.BindQuad(vertexBuffer);
+    state.DrawQuad();
+}
+
+auto BackgroundBlur::VertexShaderCode() -> const char * {
+    static const char vertexShader[] =
+            "attribute vec4 aPosition;\n"
+            "attribute vec4 aTexCoord;\n"
+            "varying vec2 vTexCoord;\n"
+            "void main() {\n"
+            "    gl_Position = aPosition;\n"
+            "#ifdef FLIP_Y\n"
+            "    vTexCoord = vec2(aTexCoord.x, 1.0 - aTexCoord.y);\n"
+            "#else\n"
+            "    vTexCoord = aTexCoord.xy;\n"
+            "#endif\n"
+            "}\n";
+
+    return vertexShader;
+}
+
+auto BackgroundBlur::FragmentDownsampleShaderCode() -> const char * {
+    static const char fragmentShader[] =
+            "precision mediump float;\n"
+            "uniform sampler2D uTexture;\n"
+            "uniform vec2 uHalfTexel;\n"
+            "varying vec2 vTexCoord;\n"
+            // The pixel itself weighs half, the four diagonal neighbours share the other half
+            "void main() {\n"
+            "    vec2 h = uHalfTexel;\n"
+            "    vec3 sum = texture2D(uTexture, vTexCoord).rgb * 4.0;\n"
+            "    sum += texture2D(uTexture, vTexCoord - h).rgb;\n"
+            "    sum += texture2D(uTexture, vTexCoord + h).rgb;\n"
+            "    sum += texture2D(uTexture, vTexCoord + vec2(h.x, -h.y)).rgb;\n"
+            "    sum += texture2D(uTexture, vTexCoord - vec2(h.x, -h.y)).rgb;\n"
+            "    gl_FragColor = vec4(sum * 0.125, 1.0);\n"
+            "}\n";
+
+    return fragmentShader;
+}
+
+auto BackgroundBlur::FragmentUpsampleShaderCode() -> const char * {
+    static const char fragmentShader[] =
+            "precision mediump float;\n"
+            "uniform sampler2D uTexture;\n"
+            "uniform vec2 uHalfTexel;\n"
+            "varying vec2 vTexCoord;\n"
+            // A ring of eight samples, the diagonal ones weigh twice as much as the axial ones
+            "void main() {\n"
+            "    vec2 h = uHalfTexel;\n"
+            "    vec3 sum = texture2D(uTexture, vTexCoord + vec2(-2.0 * h.x, 0.0)).rgb;\n"
+            "    sum += texture2D(uTexture, vTexCoord + vec2(2.0 * h.x, 0.0)).rgb;\n"
+            "    sum += texture2D(uTexture, vTexCoord + vec2(0.0, -2.0 * h.y)).rgb;\n"
+            "    sum += texture2D(uTexture, vTexCoord + vec2(0.0, 2.0 * h.y)).rgb;\n"
+            "    sum += texture2D(uTexture, vTexCoord + h).rgb * 2.0;\n"
+            "    sum += texture2D(uTexture, vTexCoord - h).rgb * 2.0;\n"
+            "    sum += texture2D(uTexture, vTexCoord + vec2(h.x, -h.y)).rgb * 2.0;\n"
+            "    sum += texture2D(uTexture, vTexCoord - vec2(h.x, -h.y)).rgb * 2.0;\n"
+            "    gl_FragColor = vec4(sum / 12.0, 1.0);\n"
+            "}\n";
+
+    return fragmentShader;
+}
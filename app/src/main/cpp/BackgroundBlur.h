@@ -0,0 +1,86 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "GLUtils.h"
+
+#include <GLES2/gl2.h>
+
+#include <cstdint>
+
+// Blurs the camera frame for the blurred background mode with a dual Kawase blur: the frame is
+// downsampled to 1/4 and 1/8 of its size and upsampled back to 1/4, every pass taking a handful
+// of bilinear samples around each pixel. The mix pass stretches the 1/4 result over the frame, so
+// the whole chain costs less than a full-resolution pass. Render targets come from the texture
+// pool. Render thread only.
+class BackgroundBlur {
+public:
+    BackgroundBlur();
+
+    ~BackgroundBlur();
+
+    BackgroundBlur(const BackgroundBlur &) = delete;
+
+    auto operator=(const BackgroundBlur &) -> BackgroundBlur & = delete;
+
+    auto Initialize() -> void;
+
+    // Acquires the levels for frames of width x height pixels, the previous ones go back to pool.
+    auto Allocate(GLTexturePool &pool, int32_t width, int32_t height) -> void;
+
+    auto Release(GLTexturePool &pool) -> void;
+
+    // Distance of the samples from the pixel in texels of the level a pass renders, 1 is the
+    // classic dual Kawase blur, larger values blur more at the same cost.
+    auto SetStrength(float strength) -> void;
+
+    // Runs the chain on frameTexture and returns the blurred texture. It is flipped vertically,
+    // so the mix pass samples it like the background bitmap.
+    auto Apply(GLuint vertexBuffer, GLuint frameTexture) const -> GLuint;
+
+private:
+    struct Level {
+        PooledTexture target;
+        int32_t width;
+        int32_t height;
+    };
+
+    auto Pass(const char *name, GLuint vertexBuffer, GLuint program, GLuint source,
+              const Level &level) const -> void;
+
+    // Sets uHalfTexel of every pass for the strength and the level sizes.
+    auto SetOffsets() const -> void;
+
+    static auto VertexShaderCode() -> const char *;
+
+    static auto FragmentDownsampleShaderCode() -> const char *;
+
+    static auto FragmentUpsampleShaderCode() -> const char *;
+
+    // The first pass reads the frame and flips it, the others read a level
+    GLuint m_frameDownProgram;
+    GLuint m_downProgram;
+    GLuint m_upProgram;
+    GLint m_frameDownHalfTexel;
+    GLint m_downHalfTexel;
+    GLint m_upHalfTexel;
+    float m_strength;
+
+    // 1/4 and 1/8 of the frame, the upsample pass renders into the 1/4 level again
+    Level m_quarter;
+    Level m_eighth;
+};
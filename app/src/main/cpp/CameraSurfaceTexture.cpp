@@ -17,12 +17,12 @@
 #include "CameraSurfaceTexture.h"
 #include "GLUtils.h"
 #include "Log.h"
+#include "Trace.h"
 
-#include <GLES2/gl2ext.h>
+#include <string>
 
 auto CameraSurfaceTexture::create() -> std::unique_ptr<CameraSurfaceTexture> {
-    auto processor = std::make_unique<CameraSurfaceTexture>();
-    return std::move(processor);
+    return std::make_unique<CameraSurfaceTexture>();
 }
 
 CameraSurfaceTexture::CameraSurfaceTexture()
@@ -30,11 +30,10 @@ CameraSurfaceTexture::CameraSurfaceTexture()
           m_width(0),
           m_height(0),
           m_inputTexture(0),
+          m_inputTarget(GL_TEXTURE_EXTERNAL_OES),
           m_framebuffer(0),
           m_vertexBuffer(0),
           m_program(0),
-          m_position(0),
-          m_texCoord(0),
           m_transformMatrix(0),
           m_rotationMatrix(0) {
 }
@@ -57,15 +56,17 @@ CameraSurfaceTexture::~CameraSurfaceTexture() {
     m_pProcessor.reset();
 }
 
-auto CameraSurfaceTexture::Initialize(AAssetManager *assetManager, GLuint inputTexture,
-                                      GLuint outputTexture) -> void {
+auto CameraSurfaceTexture::Initialize(const ModelLoader &loadModel, GLuint inputTexture,
+                                      GLuint outputTexture, const InferenceOptions &options,
+                                      GLenum inputTarget) -> void {
     m_inputTexture = inputTexture;
+    m_inputTarget = inputTarget;
 
-    glBindTexture(GL_TEXTURE_EXTERNAL_OES, inputTexture);
-    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(inputTarget, inputTexture);
+    glTexParameteri(inputTarget, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(inputTarget, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(inputTarget, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(inputTarget, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
     glGenBuffers(1, &m_vertexBuffer);
     glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
@@ -73,18 +74,22 @@ auto CameraSurfaceTexture::Initialize(AAssetManager *assetManager, GLuint inputT
 
     glGenFramebuffers(1, &m_framebuffer);
 
-    m_program = CreateProgram(VertexShaderCode(), FragmentShaderCode());
+    std::string fragmentShaderCode = inputTarget == GL_TEXTURE_EXTERNAL_OES
+                                     ? "#extension GL_OES_EGL_image_external:require\n"
+                                       "#define INPUT_SAMPLER samplerExternalOES\n"
+                                     : "#define INPUT_SAMPLER sampler2D\n";
+    fragmentShaderCode += FragmentShaderCode();
+    m_program = CreateProgram(VertexShaderCode(), fragmentShaderCode.c_str());
 
     glUseProgram(m_program);
 
-    m_position = glGetAttribLocation(m_program, "aPosition");
-    m_texCoord = glGetAttribLocation(m_program, "aTexCoord");
     m_transformMatrix = glGetUniformLocation(m_program, "uTransformMatrix");
     m_rotationMatrix = glGetUniformLocation(m_program, "uRotationMatrix");
 
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-    m_pProcessor->Initialize(assetManager, outputTexture);
+    // Also resets the GL state cache
+    m_pProcessor->Initialize(loadModel, outputTexture, options);
 }
 
 auto CameraSurfaceTexture::SetParams(int32_t width, int32_t height,
@@ -97,27 +102,42 @@ auto CameraSurfaceTexture::SetParams(int32_t width, int32_t height,
 
 auto CameraSurfaceTexture::UpdateTexImage(float *transformMatrix,
                                           float *rotationMatrix) const -> void {
-    glViewport(0, 0, m_width, m_height);
+    TRACE_SCOPE("Frame");
 
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    // Java binds the input texture to update it, the cached bindings may be stale
+    GLState::Instance().InvalidateTextures();
 
-    glDisable(GL_BLEND);
-    glBindTexture(GL_TEXTURE_EXTERNAL_OES, m_inputTexture);
+    {
+        GL_PASS("DrawInput");
+        DrawInputTexture(transformMatrix, rotationMatrix);
+    }
 
-    glUseProgram(m_program);
+    m_pProcessor->Process(m_width, m_height, m_vertexBuffer);
+}
+
+auto CameraSurfaceTexture::Processor() -> CameraVirtualBackgroundProcessor & {
+    return *m_pProcessor;
+}
+
+auto CameraSurfaceTexture::DrawInputTexture(const float *transformMatrix,
+                                            const float *rotationMatrix) const -> void {
+    auto &state = GLState::Instance();
+    state.Viewport(0, 0, m_width, m_height);
+    state.BindFramebuffer(m_framebuffer);
+
+    // uTexture samples unit 0, where the resize pass leaves the output texture bound as 2D
+    if (m_inputTarget == GL_TEXTURE_EXTERNAL_OES) {
+        state.BindTexture(0, GL_TEXTURE_2D, 0);
+    }
+    state.BindTexture(0, m_inputTarget, m_inputTexture);
+    state.SetBlending(false);
+
+    state.UseProgram(m_program);
     glUniformMatrix4fv(m_transformMatrix, 1, GL_FALSE, transformMatrix);
     glUniformMatrix4fv(m_rotationMatrix, 1, GL_FALSE, rotationMatrix);
-    glVertexAttribPointer(m_position, 4, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat),
-                          (const GLvoid *) (0 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(m_position);
-    glVertexAttribPointer(m_texCoord, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat),
-                          (const GLvoid *) (4 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(m_texCoord);
-    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
-    glDrawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_SHORT, VertexIndices());
 
-    m_pProcessor->Process(m_width, m_height, m_vertexBuffer);
+    state.BindQuad(m_vertexBuffer);
+    state.DrawQuad();
 }
 
 auto CameraSurfaceTexture::VertexShaderCode() -> const char * {
@@ -137,9 +157,9 @@ auto CameraSurfaceTexture::VertexShaderCode() -> const char * {
 
 auto CameraSurfaceTexture::FragmentShaderCode() -> const char * {
     static const char fragmentShader[] =
-            "#extension GL_OES_EGL_image_external:require\n"
             "precision mediump float;\n"
-            "uniform samplerExternalOES uTexture;\n"
+            // samplerExternalOES for the camera, see Initialize()
+            "uniform INPUT_SAMPLER uTexture;\n"
             "varying vec2 vTexCoord;\n"
             "void main() {\n"
             "    gl_FragColor = texture2D(uTexture, vTexCoord);\n"
@@ -18,6 +18,8 @@
 
 #include "CameraVirtualBackgroundProcessor.h"
 
+#include <GLES2/gl2ext.h>
+
 #include <memory>
 
 class CameraSurfaceTexture {
@@ -28,22 +30,31 @@ public:
 
     virtual ~CameraSurfaceTexture();
 
-    auto Initialize(AAssetManager *assetManager, GLuint inputTexture, GLuint outputTexture) -> void;
+    // inputTarget is GL_TEXTURE_EXTERNAL_OES for the camera, the test harness feeds frames
+    // through a plain GL_TEXTURE_2D.
+    auto Initialize(const ModelLoader &loadModel, GLuint inputTexture, GLuint outputTexture,
+                    const InferenceOptions &options,
+                    GLenum inputTarget = GL_TEXTURE_EXTERNAL_OES) -> void;
 
     auto SetParams(int32_t width, int32_t height, GLuint backgroundTexture) -> void;
 
     auto UpdateTexImage(float *transformMatrix, float *rotationMatrix) const -> void;
 
+    auto Processor() -> CameraVirtualBackgroundProcessor &;
+
 private:
+    // Renders the camera frame from the input texture into the processor input.
+    auto DrawInputTexture(const float *transformMatrix,
+                             const float *rotationMatrix) const -> void;
+
     std::unique_ptr<CameraVirtualBackgroundProcessor> m_pProcessor;
     int32_t m_width;
     int32_t m_height;
     GLuint m_inputTexture;
+    GLenum m_inputTarget;
     GLuint m_framebuffer;
     GLuint m_vertexBuffer;
     GLuint m_program;
-    GLint m_position;
-    GLint m_texCoord;
     GLint m_transformMatrix;
     GLint m_rotationMatrix;
 
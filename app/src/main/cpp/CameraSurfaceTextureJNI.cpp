@@ -17,6 +17,7 @@
 #include "CameraSurfaceTextureJNI.h"
 
 #include "CameraSurfaceTexture.h"
+#include "ModelAssets.h"
 
 #include <android/asset_manager_jni.h>
 
@@ -32,12 +33,22 @@ JNI_METHOD(jlong, create)(JNIEnv *env, jobject obj) {
     return static_cast<long>(reinterpret_cast<uintptr_t>(surfaceTexture.release()));
 }
 
-JNI_METHOD(void, nativeInit)(JNIEnv *env, jobject obj, jobject _assetManager, jlong _surfaceView,
-                             jint inputTexture, jint outputTexture) {
+JNI_METHOD(void, nativeInit)(JNIEnv *env, jobject obj, jobject _assetManager, jstring _cacheDir,
+                             jlong _surfaceView, jint inputTexture, jint outputTexture) {
     if (_surfaceView == 0L) return;
 
+    InferenceOptions options;
+    const char *cacheDir = env->GetStringUTFChars(_cacheDir, nullptr);
+    options.cacheDirectory = cacheDir;
+    env->ReleaseStringUTFChars(_cacheDir, cacheDir);
+
+    // The Java AssetManager lives as long as the application
     auto assetManager = AAssetManager_fromJava(env, _assetManager);
-    castToSurfaceTexture(_surfaceView)->Initialize(assetManager, inputTexture, outputTexture);
+    auto loadModel = [assetManager](const char *path) {
+        return OpenModelAsset(assetManager, path);
+    };
+    castToSurfaceTexture(_surfaceView)->Initialize(loadModel, inputTexture, outputTexture,
+                                                   options);
 }
 
 JNI_METHOD(void, nativeSetParams)(JNIEnv *env, jobject obj, jlong _surfaceView, jint width,
@@ -59,6 +70,21 @@ JNI_METHOD(void, nativeUpdateTexImage)(JNIEnv *env, jobject obj, jlong _surfaceV
     env->ReleaseFloatArrayElements(extraTransformMatrix, extraMatrix, 0);
 }
 
+JNI_METHOD(void, nativeSelectModel)(JNIEnv *env, jobject obj, jlong _surfaceView, jstring _name) {
+    if (_surfaceView == 0L) return;
+
+    const char *name = env->GetStringUTFChars(_name, nullptr);
+    castToSurfaceTexture(_surfaceView)->Processor().SelectModel(name);
+    env->ReleaseStringUTFChars(_name, name);
+}
+
+JNI_METHOD(void, nativeSetLatencyBudget)(JNIEnv *env, jobject obj, jlong _surfaceView,
+                                         jfloat budgetMs) {
+    if (_surfaceView == 0L) return;
+
+    castToSurfaceTexture(_surfaceView)->Processor().SetLatencyBudget(budgetMs);
+}
+
 JNI_METHOD(void, nativeRelease)(JNIEnv *env, jobject obj, jlong _surfaceView) {
     if (_surfaceView == 0L) return;
 
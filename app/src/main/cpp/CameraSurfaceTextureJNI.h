@@ -27,8 +27,8 @@ extern "C" {
 
 JNI_METHOD(jlong, create)(JNIEnv *env, jobject obj);
 
-JNI_METHOD(void, nativeInit)(JNIEnv *env, jobject obj, jobject _assetManager, jlong _surfaceView,
-                             jint inputTexture, jint outputTexture);
+JNI_METHOD(void, nativeInit)(JNIEnv *env, jobject obj, jobject _assetManager, jstring _cacheDir,
+                             jlong _surfaceView, jint inputTexture, jint outputTexture);
 
 JNI_METHOD(void, nativeSetParams)(JNIEnv *env, jobject obj, jlong _surfaceView, jint width,
                                   jint height, jint backgroundTexture);
@@ -37,6 +37,11 @@ JNI_METHOD(void, nativeUpdateTexImage)(JNIEnv *env, jobject obj, jlong _surfaceV
                                        jfloatArray transformMatrix,
                                        jfloatArray extraTransformMatrix);
 
+JNI_METHOD(void, nativeSelectModel)(JNIEnv *env, jobject obj, jlong _surfaceView, jstring _name);
+
+JNI_METHOD(void, nativeSetLatencyBudget)(JNIEnv *env, jobject obj, jlong _surfaceView,
+                                         jfloat budgetMs);
+
 JNI_METHOD(void, nativeRelease)(JNIEnv *env, jobject obj, jlong _surfaceView);
 
 #ifdef __cplusplus
@@ -19,17 +19,14 @@
 #include "Log.h"
 
 auto CameraSurfaceView::create() -> std::unique_ptr<CameraSurfaceView> {
-    auto processor = std::make_unique<CameraSurfaceView>();
-    return std::move(processor);
+    return std::make_unique<CameraSurfaceView>();
 }
 
 CameraSurfaceView::CameraSurfaceView()
         : m_surfaceWidth(0),
           m_surfaceHeight(0),
           m_vertexBuffer(0),
-          m_program(0),
-          m_position(0),
-          m_texCoord(0) {
+          m_program(0) {
 }
 
 CameraSurfaceView::~CameraSurfaceView() {
@@ -53,9 +50,6 @@ auto CameraSurfaceView::OnSurfaceCreated() -> void {
 
     glUseProgram(m_program);
 
-    m_position = glGetAttribLocation(m_program, "aPosition");
-    m_texCoord = glGetAttribLocation(m_program, "aTexCoord");
-
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
     if (glGetError() != GL_NO_ERROR) {
@@ -63,6 +57,9 @@ auto CameraSurfaceView::OnSurfaceCreated() -> void {
         LOGE("Could not create program.");
         return;
     }
+
+    // The surface view and the camera texture share one context on the GL thread
+    GLState::Instance().Reset();
 }
 
 auto CameraSurfaceView::OnSurfaceChanged(int32_t width, int32_t height) -> void {
@@ -71,7 +68,7 @@ auto CameraSurfaceView::OnSurfaceChanged(int32_t width, int32_t height) -> void
 }
 
 auto CameraSurfaceView::OnDrawFrame() -> void {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLState::Instance().BindFramebuffer(0);
 
     glClearColor(0.0, 0.0, 0.0, 1.0);
     glClear(GL_COLOR_BUFFER_BIT);
@@ -79,9 +76,9 @@ auto CameraSurfaceView::OnDrawFrame() -> void {
 
 auto CameraSurfaceView::DrawTexture(GLuint texture, int32_t textureWidth,
                                     int32_t textureHeight) const -> void {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    auto &state = GLState::Instance();
+    state.BindFramebuffer(0);
+    state.BindTexture(0, GL_TEXTURE_2D, texture);
 
     int viewportX = 0;
     int viewportY = 0;
@@ -101,17 +98,11 @@ auto CameraSurfaceView::DrawTexture(GLuint texture, int32_t textureWidth,
         viewportHeight = candidateHeight;
     }
 
-    glViewport(viewportX, viewportY, viewportWidth, viewportHeight);
+    state.Viewport(viewportX, viewportY, viewportWidth, viewportHeight);
 
-    glUseProgram(m_program);
-    glVertexAttribPointer(m_position, 4, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat),
-                          (const GLvoid *) (0 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(m_position);
-    glVertexAttribPointer(m_texCoord, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat),
-                          (const GLvoid *) (4 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(m_texCoord);
-    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
-    glDrawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_SHORT, VertexIndices());
+    state.UseProgram(m_program);
+    state.BindQuad(m_vertexBuffer);
+    state.DrawQuad();
 }
 
 const char *CameraSurfaceView::VertexShaderCode() {
@@ -41,8 +41,6 @@ private:
     int32_t m_surfaceHeight;
     GLuint m_vertexBuffer;
     GLuint m_program;
-    GLint m_position;
-    GLint m_texCoord;
 
 private:
     static auto VertexShaderCode() -> const char *;
@@ -17,120 +17,69 @@
 #include "CameraVirtualBackgroundProcessor.h"
 
 #include "GLUtils.h"
+#include "ImageUtils.h"
 #include "Log.h"
 
-#include <tuple>
+#include <algorithm>
+#include <cinttypes>
+#include <iterator>
+#include <string>
 
-#include <tensorflow/lite/core/interpreter_builder.h>
-#include <tensorflow/lite/kernels/register.h>
-#include <tensorflow/lite/model_builder.h>
-#include <tensorflow/lite/core/api/op_resolver.h>
+static constexpr uint64_t kStatsLogInterval = 300;
 
-struct RGB {
-    unsigned char red;
-    unsigned char green;
-    unsigned char blue;
-};
+// Loaded by Initialize, the only model shipped in the assets
+static constexpr char kDefaultModel[] = "square";
 
-static void AddPadding(const std::vector<GLubyte> &srcImage, int32_t srcWidth, int32_t srcHeight,
-                       std::vector<GLubyte> &dstImage, int32_t dstWidth, int32_t dstHeight,
-                       GLubyte padValue = 0) {
-    // Ensure destination image has correct size and initialize with padding color (e.g., black)
-    dstImage.resize(dstWidth * dstHeight * 3, padValue);
+// Range sigma of the mask refinement on luminance in [0, 1], same default as MaskRefiner
+static constexpr float kRefineRangeSigma = 0.1f;
 
-    // Copy each row from the source image to the destination image
-    for (int y = 0; y < srcHeight; ++y) {
-        // Source row starting index
-        int srcIndex = y * srcWidth * 3;
-
-        // Destination row starting index (we center it horizontally)
-        int dstIndex = y * dstWidth * 3 + ((dstWidth - srcWidth) / 2) * 3;
-
-        // Copy the row from source to destination
-        std::copy(srcImage.begin() + srcIndex, srcImage.begin() + srcIndex + (srcWidth * 3),
-                  dstImage.begin() + dstIndex);
-    }
-}
-
-static void RemovePadding(const std::vector<GLubyte> &srcImage, int32_t srcWidth, int32_t srcHeight,
-                          std::vector<GLubyte> &dstImage, int32_t dstWidth, int32_t dstHeight) {
-    // Ensure destination image has correct size
-    dstImage.resize(dstWidth * dstHeight * 3);
-
-    // Calculate the horizontal and vertical padding
-    int horizontalPadding = (srcWidth - dstWidth) / 2;
-
-    // Copy each row from the source image to the destination image
-    for (int y = 0; y < dstHeight; ++y) {
-        // Source row starting index (we skip the padding on both sides horizontally)
-        int srcIndex = y * srcWidth * 3 + horizontalPadding * 3;
-
-        // Destination row starting index
-        int dstIndex = y * dstWidth * 3;
-
-        // Copy the row from source to destination (cropping the padding)
-        std::copy(srcImage.begin() + srcIndex, srcImage.begin() + srcIndex + (dstWidth * 3),
-                  dstImage.begin() + dstIndex);
-    }
-}
-
-static std::tuple<int32_t, int32_t> ResizeImageToFit(int32_t originalWidth, int32_t originalHeight,
-                                                     int32_t modelWidth, int32_t modelHeight) {
-    auto aspectRatio = static_cast<float>(originalWidth) / static_cast<float>(originalHeight);
-    int imageWidth, imageHeight;
-
-    // Check if the image is wider (landscape) or taller (portrait)
-    if (aspectRatio > 1.0f) {
-        imageWidth = modelWidth;
-        imageHeight = static_cast<int32_t>(static_cast<float>(modelWidth) / aspectRatio);
-    } else {
-        imageHeight = modelHeight;
-        imageWidth = static_cast<int32_t>(static_cast<float>(modelHeight) * aspectRatio);
-    }
-
-    if (imageWidth > modelWidth) {
-        imageWidth = modelWidth;
-        imageHeight = static_cast<int32_t>(static_cast<float>(modelWidth) / aspectRatio);
-    }
-
-    if (imageHeight > modelHeight) {
-        imageHeight = modelHeight;
-        imageWidth = static_cast<int32_t>(static_cast<float>(modelHeight) * aspectRatio);
-    }
-
-    return std::make_tuple(imageWidth, imageHeight);
-}
+// PixelReader returns RGBA, the segmenter drops alpha while it normalizes the input
+static constexpr int32_t kReadbackChannels = 4;
 
 CameraVirtualBackgroundProcessor::CameraVirtualBackgroundProcessor()
-        : m_texture(0),
+        : m_pModel(nullptr),
+          m_latencyBudget(0.0f),
+          m_copiedBytes(0),
+          m_frameTexture{0, 0},
           m_outputFramebuffer(0),
+          m_cameraFramebuffer(0),
           m_outputTexture(0),
+          m_outputWidth(0),
+          m_outputHeight(0),
           m_backgroundTexture(0),
-          m_maskTexture(0),
+          m_blurStrength(0.0f),
+          m_maskTexture{0, 0},
           m_resizeProgram(0),
-          m_resizePosition(0),
-          m_resizeTexCoord(0),
-          m_resizeFramebuffer(0),
-          m_resizeTexture(0),
+          m_resizeRegion(-1),
+          m_resizeTarget{0, 0},
           m_mixProgram(0),
-          m_mixPosition(0),
-          m_mixTexCoord(0),
+          m_mixMaskRegion(-1),
+          m_refineMixProgram(0),
+          m_refineMixMaskRegion(-1),
+          m_refineMixMaskSize(-1),
+          m_refineMask(true),
+          m_trackRegion(true),
+          m_maskRegion(RegionTracker::kFullFrame),
           m_modelWidth(0),
           m_modelHeight(0),
           m_imageWidth(0),
-          m_imageHeight(0) {
+          m_imageHeight(0),
+          m_tileOffsetX(0),
+          m_frameWidth(0),
+          m_frameHeight(0),
+          m_frameIndex(0),
+          m_maskFrameIndex(0),
+          m_timeToFirstMask(0.0),
+          m_statsInferredFrames(0),
+          m_statsSkippedFrames(0),
+          m_statsGLCalls() {
 }
 
 CameraVirtualBackgroundProcessor::~CameraVirtualBackgroundProcessor() {
-    if (m_texture != 0) {
-        glDeleteTextures(1, &m_texture);
-        m_texture = 0;
-    }
+    m_worker.Stop();
 
-    if (m_maskTexture != 0) {
-        glDeleteTextures(1, &m_maskTexture);
-        m_maskTexture = 0;
-    }
+    m_blur.Release(m_texturePool);
+    m_texturePool.Clear();
 
     if (m_outputFramebuffer != 0) {
         glDeleteFramebuffers(1, &m_outputFramebuffer);
@@ -144,149 +93,292 @@ CameraVirtualBackgroundProcessor::~CameraVirtualBackgroundProcessor() {
     if (m_mixProgram != 0) {
         DeleteProgram(m_mixProgram);
     }
+
+    if (m_refineMixProgram != 0) {
+        DeleteProgram(m_refineMixProgram);
+    }
 }
 
-auto CameraVirtualBackgroundProcessor::Initialize(AAssetManager *assetManager,
-                                                  GLuint outputTexture) -> void {
-    AAsset *modelFile = AAssetManager_open(assetManager, "model/selfie_segmenter.tflite",
-                                           AASSET_MODE_BUFFER);
-    CHECK(modelFile);
-    const size_t bufferSize = AAsset_getLength(modelFile);
-    std::vector<const char *> buffer(bufferSize);
-    int status = AAsset_read(modelFile, buffer.data(), bufferSize);
-    AAsset_close(modelFile);
-    CHECK(status >= 0);
+auto CameraVirtualBackgroundProcessor::Initialize(const ModelLoader &loadModel,
+                                                  GLuint outputTexture,
+                                                  const InferenceOptions &options) -> void {
+    m_initializeTime = std::chrono::steady_clock::now();
+    m_loadModel = loadModel;
+    m_options = options;
 
-    auto model = tflite::FlatBufferModel::BuildFromBuffer(
-            reinterpret_cast<const char *>(buffer.data()), bufferSize);
+    auto pModel = FindModel(kDefaultModel);
+    CHECK(pModel != nullptr && LoadModel(*pModel, m_loadModel(pModel->path)));
 
-    CHECK(model);
-    tflite::ops::builtin::BuiltinOpResolver resolver;
-    tflite::InterpreterBuilder(*model, resolver)(&m_pInterpreter);
+    m_outputTexture = outputTexture;
 
-    CHECK(m_pInterpreter);
-    CHECK(m_pInterpreter->AllocateTensors() == kTfLiteOk);
+    // The output texture storage is allocated by SetParams(), the framebuffer only once
+    glGenFramebuffers(1, &m_outputFramebuffer);
 
-    auto tensorInputIndex = m_pInterpreter->inputs()[0];
-    m_modelHeight = m_pInterpreter->tensor(tensorInputIndex)->dims->data[1];
-    m_modelWidth = m_pInterpreter->tensor(tensorInputIndex)->dims->data[2];
+    m_resizeProgram = CreateProgram(VertexResizerShaderCode(), FragmentResizerShaderCode());
+    m_resizeRegion = glGetUniformLocation(m_resizeProgram, "uRegion");
 
-    m_modelData.reserve(m_modelWidth * m_modelHeight * 3);
+    m_mixProgram = CreateProgram(VertexMixerShaderCode(), FragmentMixerShaderCode());
+    m_mixMaskRegion = glGetUniformLocation(m_mixProgram, "uMaskRegion");
+    SetMixSamplers(m_mixProgram);
 
-    m_outputTexture = outputTexture;
+    std::string refineMixShaderCode = "#define REFINE_MASK\n";
+    refineMixShaderCode += FragmentMixerShaderCode();
+    m_refineMixProgram = CreateProgram(VertexMixerShaderCode(), refineMixShaderCode.c_str());
+    m_refineMixMaskRegion = glGetUniformLocation(m_refineMixProgram, "uMaskRegion");
+    m_refineMixMaskSize = glGetUniformLocation(m_refineMixProgram, "uMaskSize");
+    SetMixSamplers(m_refineMixProgram);
+    glUniform1f(glGetUniformLocation(m_refineMixProgram, "uRangeScale"),
+                1.0f / (kRefineRangeSigma * kRefineRangeSigma));
 
-    glGenTextures(1, &m_texture);
-    glGenTextures(1, &m_maskTexture);
+    m_blur.Initialize();
 
-    m_resizeProgram = CreateProgram(VertexResizerShaderCode(), FragmentResizerShaderCode());
+    GLState::Instance().Reset();
+}
 
-    m_resizePosition = glGetAttribLocation(m_resizeProgram, "aPosition");
-    m_resizeTexCoord = glGetAttribLocation(m_resizeProgram, "aTexCoord");
+auto CameraVirtualBackgroundProcessor::SetMixSamplers(GLuint program) -> void {
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "uTexture"), 0);  // 0 = GL_TEXTURE0
+    glUniform1i(glGetUniformLocation(program, "uBackgroundTexture"), 1);  // 1 = GL_TEXTURE1
+    glUniform1i(glGetUniformLocation(program, "uMaskTexture"), 2);  // 2 = GL_TEXTURE2
+}
 
-    m_mixProgram = CreateProgram(VertexMixerShaderCode(), FragmentMixerShaderCode());
+auto CameraVirtualBackgroundProcessor::LoadModel(const ModelDescriptor &model,
+                                                 std::unique_ptr<ModelFile> pModelFile) -> bool {
+    const auto start = std::chrono::steady_clock::now();
+    const auto residentBefore = ResidentMemory();
+
+    if (!pModelFile) {
+        return false;
+    }
+    const auto mapped = pModelFile->IsMapped();
 
-    m_mixPosition = glGetAttribLocation(m_mixProgram, "aPosition");
-    m_mixTexCoord = glGetAttribLocation(m_mixProgram, "aTexCoord");
+    if (!m_segmenter.Initialize(std::move(pModelFile), model, m_options)) {
+        return false;
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    LOGI("Model %s %s and interpreter ready in %.1f ms, resident memory %.1f -> %.1f MB\n",
+         model.name, mapped ? "mapped" : "copied",
+         std::chrono::duration<double, std::milli>(end - start).count(),
+         static_cast<double>(residentBefore) / (1024.0 * 1024.0),
+         static_cast<double>(ResidentMemory()) / (1024.0 * 1024.0));
+
+    m_pModel = &model;
+    m_modelWidth = m_segmenter.Width();
+    m_modelHeight = m_segmenter.Height();
+    return true;
 }
 
-auto CameraVirtualBackgroundProcessor::SetParams(int32_t width, int32_t height,
-                                                 GLuint backgroundTexture,
-                                                 GLuint framebuffer) -> void {
-    if (!glIsTexture(backgroundTexture)) {
-        BindFramebuffer(framebuffer, m_outputTexture, width, height);
-        return;
+auto CameraVirtualBackgroundProcessor::SelectModel(const char *name) -> bool {
+    auto pModel = FindModel(name);
+    if (pModel == nullptr) {
+        LOGE("Unknown model %s\n", name);
+        return false;
+    }
+    if (pModel == m_pModel) {
+        return true;
     }
 
-    BindFramebuffer(framebuffer, m_texture, width, height);
+    // A missing asset leaves the running model and the worker alone
+    auto pModelFile = m_loadModel(pModel->path);
+    if (!pModelFile) {
+        LOGE("Could not open model %s, keeping %s\n", pModel->name, m_pModel->name);
+        return false;
+    }
 
-    m_backgroundTexture = backgroundTexture;
+    // The worker runs the interpreter that is about to be replaced
+    m_worker.Stop();
 
-    auto [imageWidth, imageHeight] = ResizeImageToFit(width, height, m_modelWidth, m_modelHeight);
+    // A failed Segmenter::Initialize has released the previous interpreter already
+    auto loaded = LoadModel(*pModel, std::move(pModelFile));
+    if (!loaded) {
+        LOGE("Could not load model %s, keeping %s\n", pModel->name, m_pModel->name);
+        if (!LoadModel(*m_pModel, m_loadModel(m_pModel->path))) {
+            LOGE("Could not reload model %s\n", m_pModel->name);
+            return false;
+        }
+    }
 
-    m_imageWidth = imageWidth;
-    m_imageHeight = imageHeight;
+    if (IsSegmenting()) {
+        ConfigureModel();
+    }
+    return loaded;
+}
 
-    m_imageData.reserve(m_imageWidth * m_imageHeight * 3);
+auto CameraVirtualBackgroundProcessor::SetLatencyBudget(float budgetMs) -> void {
+    m_latencyBudget = budgetMs;
+}
 
-    if (glIsFramebuffer(m_resizeFramebuffer)) {
-        glDeleteFramebuffers(1, &m_resizeFramebuffer);
+auto CameraVirtualBackgroundProcessor::CheckLatencyBudget() -> void {
+    const auto invokeTime = m_segmenter.RecentInvokeTime();
+    if (m_latencyBudget <= 0.0f || invokeTime <= m_latencyBudget) {
+        return;
     }
-    glGenFramebuffers(1, &m_resizeFramebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_resizeFramebuffer);
 
-    if (glIsTexture(m_resizeTexture)) {
-        glDeleteTextures(1, &m_resizeTexture);
+    // Switching resets the invoke time, the next check measures the new model
+    for (auto pModel = FasterModel(*m_pModel); pModel != nullptr; pModel = FasterModel(*pModel)) {
+        LOGI("Invoke time %.1f ms over the %.1f ms budget, switching from %s to %s\n",
+             invokeTime, m_latencyBudget, m_pModel->name, pModel->name);
+        if (SelectModel(pModel->name)) {
+            return;
+        }
     }
-    glGenTextures(1, &m_resizeTexture);
-    glBindTexture(GL_TEXTURE_2D, m_resizeTexture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, m_modelWidth, m_modelHeight, 0, GL_RGB, GL_UNSIGNED_BYTE,
-                 nullptr);
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    // Nothing faster to load, do not retry on every check
+    LOGE("No faster model available, latency budget disabled\n");
+    m_latencyBudget = 0.0f;
+}
 
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_resizeTexture, 0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+auto CameraVirtualBackgroundProcessor::SetParams(int32_t width, int32_t height,
+                                                 GLuint backgroundTexture,
+                                                 GLuint framebuffer) -> void {
+    m_backgroundTexture = backgroundTexture;
+    m_cameraFramebuffer = framebuffer;
+    ConfigureOutput(width, height);
+}
 
-    if (glIsFramebuffer(m_outputFramebuffer)) {
-        glDeleteFramebuffers(1, &m_outputFramebuffer);
+auto CameraVirtualBackgroundProcessor::IsSegmenting() const -> bool {
+    return m_backgroundTexture != 0 || m_blurStrength > 0.0f;
+}
+
+auto CameraVirtualBackgroundProcessor::ConfigureOutput(int32_t width, int32_t height) -> void {
+    // The worker reads the image and model sizes, keep it idle while they change
+    m_worker.Stop();
+
+    // Without segmentation the camera frame is rendered straight into the output texture
+    AllocateOutputTexture(width, height);
+
+    if (!IsSegmenting()) {
+        m_blur.Release(m_texturePool);
+        AttachTexture(m_cameraFramebuffer, m_outputTexture);
+        GLState::Instance().Reset();
+        return;
     }
-    glGenFramebuffers(1, &m_outputFramebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_outputFramebuffer);
 
-    glBindTexture(GL_TEXTURE_2D, m_outputTexture);
+    // The camera frame is drawn into a pooled texture, a size used before gets the same one back
+    m_texturePool.Release(m_frameTexture);
+    m_frameTexture = m_texturePool.Acquire(width, height, GL_RGBA, GL_LINEAR, false);
+    AttachTexture(m_cameraFramebuffer, m_frameTexture.texture);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    m_frameWidth = width;
+    m_frameHeight = height;
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    ConfigureModel();
 
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_outputTexture, 0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // The blur levels are only held while the blur is on, see SetBackgroundBlur()
+    if (m_blurStrength > 0.0f) {
+        m_blur.Allocate(m_texturePool, width, height);
+    } else {
+        m_blur.Release(m_texturePool);
+    }
+
+    AttachTexture(m_outputFramebuffer, m_outputTexture);
+
+    GLState::Instance().Reset();
 }
 
-auto CameraVirtualBackgroundProcessor::Invoke() const -> void {
-    using clock = std::chrono::steady_clock;
+auto CameraVirtualBackgroundProcessor::ConfigureModel() -> void {
+    auto [imageWidth, imageHeight] = ResizeImageToFit(m_frameWidth, m_frameHeight, m_modelWidth,
+                                                      m_modelHeight);
 
-    const auto start = clock::now();
-    {
-        const auto status = m_pInterpreter->Invoke();
-        assert(status == kTfLiteOk);
-    }
-    const auto end = clock::now();
+    m_imageWidth = imageWidth;
+    m_imageHeight = imageHeight;
+    // The image goes to the top of the model tile, centered horizontally like PadAndNormalize
+    // places it
+    m_tileOffsetX = (m_modelWidth - m_imageWidth) / 2;
+
+    // The mask covers the whole model tile, the mix pass only samples the image part of it
+    m_texturePool.Release(m_maskTexture);
+    m_maskTexture = m_texturePool.Acquire(m_modelWidth, m_modelHeight, GL_LUMINANCE, GL_LINEAR,
+                                          false);
+
+    // Masks of the previous stream must not bleed into the new one, nor undefined contents of a
+    // new texture
+    std::vector<GLubyte> emptyMask(static_cast<size_t>(m_modelWidth) * m_modelHeight, 0);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_modelWidth, m_modelHeight, GL_LUMINANCE,
+                    GL_UNSIGNED_BYTE, emptyMask.data());
+
+    // Leaves the framebuffer bound, the pixel reader picks the readback format of it
+    m_texturePool.Release(m_resizeTarget);
+    m_resizeTarget = m_texturePool.Acquire(m_modelWidth, m_modelHeight, GL_RGB, GL_NEAREST, true);
+
+    // Resize only ever draws the image part, the padding around it is cleared once to the zero
+    // pixel the model expects there
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    m_pixelReader.Initialize(m_modelWidth, m_modelHeight);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    auto time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    LOGI("Texture pool: %" PRIu64 " allocated, %" PRIu64 " reused\n",
+         m_texturePool.Allocations(), m_texturePool.Reuses());
+
+    LOGI("Readback %s, mask latency %d frame(s)\n",
+         m_pixelReader.IsAsync() ? "asynchronous (GLES3 pixel pack buffers)" : "synchronous",
+         m_pixelReader.Latency());
+
+    SetMaskTile(m_mixProgram);
+    SetMaskTile(m_refineMixProgram);
+    glUniform2f(m_refineMixMaskSize, static_cast<GLfloat>(m_modelWidth),
+                static_cast<GLfloat>(m_modelHeight));
+    GLState::Instance().Reset();
+
+    m_segmenter.ResetTemporalFilter();
+    m_scheduler.Reset(m_imageWidth, m_imageHeight, m_modelWidth, kReadbackChannels);
+    m_regionTracker.Reset();
+    std::fill(std::begin(m_resizeRegions), std::end(m_resizeRegions), RegionTracker::kFullFrame);
+    m_maskRegion = RegionTracker::kFullFrame;
+
+    // The readback is the letterboxed model tile, so it fills the input tensor as is
+    auto imageSize = m_pixelReader.FrameSize();
+    auto maskSize = static_cast<size_t>(m_modelWidth) * m_modelHeight;
+    m_worker.Start([this, maskSize](const std::vector<GLubyte> &image, const MaskRegion &region,
+                                    std::vector<GLubyte> &mask) {
+        m_segmenter.Segment(image, m_modelWidth, m_modelHeight, kReadbackChannels, region, mask);
+
+        // The mask is uploaded as is, so it is copied once more into the texture
+        m_copiedBytes = m_pixelReader.FrameSize() + m_segmenter.CopiedBytes() + maskSize;
+    }, imageSize, maskSize);
+}
 
-    LOGI("Tensorflow invoke time %lld ms\n", time);
+auto CameraVirtualBackgroundProcessor::SetMaskTile(GLuint program) const -> void {
+    const auto tileWidth = static_cast<GLfloat>(m_modelWidth);
+    const auto tileHeight = static_cast<GLfloat>(m_modelHeight);
+    const auto scaleX = static_cast<GLfloat>(m_imageWidth) / tileWidth;
+    const auto scaleY = static_cast<GLfloat>(m_imageHeight) / tileHeight;
+    const auto offsetX = static_cast<GLfloat>(m_tileOffsetX) / tileWidth;
+
+    glUseProgram(program);
+    glUniform4f(glGetUniformLocation(program, "uMaskTile"), scaleX, scaleY, offsetX, 0.0f);
+    // Half a texel inside the image part, so bilinear sampling never blends in the padding
+    glUniform4f(glGetUniformLocation(program, "uMaskBounds"), offsetX + 0.5f / tileWidth,
+                0.5f / tileHeight, offsetX + scaleX - 0.5f / tileWidth,
+                scaleY - 0.5f / tileHeight);
 }
 
 auto
 CameraVirtualBackgroundProcessor::UpdateTexture(const std::vector<GLubyte> &pixelData,
                                                 int32_t width,
                                                 int32_t height, GLuint texture) -> void {
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    GL_PASS("MaskUpload");
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB,
-                 GL_UNSIGNED_BYTE, pixelData.data());
+    // The texture is allocated at this size by ConfigureModel(), only the texels change
+    GLState::Instance().BindTexture(2, GL_TEXTURE_2D, texture);
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_LUMINANCE, GL_UNSIGNED_BYTE,
+                    pixelData.data());
 }
 
-auto CameraVirtualBackgroundProcessor::BindFramebuffer(GLuint framebuffer, GLuint texture,
-                                                       int32_t width, int32_t height) -> void {
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+auto CameraVirtualBackgroundProcessor::AllocateOutputTexture(int32_t width,
+                                                             int32_t height) -> void {
+    // The output texture belongs to Java, its storage is only replaced when the size changes
+    if (width == m_outputWidth && height == m_outputHeight) {
+        return;
+    }
+    m_outputWidth = width;
+    m_outputHeight = height;
 
-    glBindTexture(GL_TEXTURE_2D, texture);
+    glBindTexture(GL_TEXTURE_2D, m_outputTexture);
 
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
 
@@ -294,124 +386,216 @@ auto CameraVirtualBackgroundProcessor::BindFramebuffer(GLuint framebuffer, GLuin
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
 
+auto CameraVirtualBackgroundProcessor::AttachTexture(GLuint framebuffer, GLuint texture) -> void {
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 auto CameraVirtualBackgroundProcessor::Process(int32_t width, int32_t height,
                                                GLuint vertexBuffer) -> void {
-    if (glIsTexture(m_backgroundTexture)) {
-        Resize(vertexBuffer, m_texture);
+    if (IsSegmenting()) {
+        // Remember the region until the frame leaves the readback ring in Process()
+        const auto &region = m_trackRegion ? m_regionTracker.Current() : RegionTracker::kFullFrame;
+        m_resizeRegions[(m_frameIndex + 1) % kRegionHistory] = region;
+
+        Resize(vertexBuffer, m_frameTexture.texture, region);
         Process();
-        Mix(width, height, vertexBuffer, m_texture);
+        auto background = m_blurStrength > 0.0f
+                          ? m_blur.Apply(vertexBuffer, m_frameTexture.texture)
+                          : m_backgroundTexture;
+        Mix(width, height, vertexBuffer, m_frameTexture.texture, background);
     }
 }
 
-auto CameraVirtualBackgroundProcessor::Resize(GLuint vertexBuffer, GLuint texture) const -> void {
-    glViewport(0, 0, m_imageWidth, m_imageHeight);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, m_resizeFramebuffer);
+auto CameraVirtualBackgroundProcessor::Resize(GLuint vertexBuffer, GLuint texture,
+                                              const MaskRegion &region) const -> void {
+    GL_PASS("Resize");
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    auto &state = GLState::Instance();
+    state.Viewport(m_tileOffsetX, 0, m_imageWidth, m_imageHeight);
+    state.BindFramebuffer(m_resizeTarget.framebuffer);
+    state.BindTexture(0, GL_TEXTURE_2D, texture);
+    state.UseProgram(m_resizeProgram);
 
-    glUseProgram(m_resizeProgram);
+    glUniform4f(m_resizeRegion, region.x, region.y, region.width, region.height);
 
-    glVertexAttribPointer(m_resizePosition, 4, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat),
-                          (const GLvoid *) (0 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(m_resizePosition);
-    glVertexAttribPointer(m_resizeTexCoord, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat),
-                          (const GLvoid *) (4 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(m_resizeTexCoord);
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-    glDrawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_SHORT, VertexIndices());
+    state.BindQuad(vertexBuffer);
+    state.DrawQuad();
 }
 
 auto CameraVirtualBackgroundProcessor::Process() -> void {
-    glReadPixels(0, 0, m_imageWidth, m_imageHeight, GL_RGB, GL_UNSIGNED_BYTE, m_imageData.data());
+    m_frameIndex++;
+
+    // Hand the frame leaving the readback ring over to the worker, or discard it when the worker
+    // queue is full. A frame that barely differs from the last segmented one is not submitted,
+    // its slot is simply refilled next time and the last mask stays in place.
+    auto frame = m_worker.AcquireFrame();
+    bool read;
+    {
+        GL_PASS("Readback");
+        read = m_pixelReader.Read(frame != nullptr ? frame->pixels.data() : nullptr);
+    }
+    if (read && m_scheduler.ShouldInfer(frame->pixels.data() + m_tileOffsetX * kReadbackChannels)) {
+        auto frameIndex = m_frameIndex - m_pixelReader.Latency();
+        frame->region = m_resizeRegions[frameIndex % kRegionHistory];
+        m_worker.SubmitFrame(frameIndex);
+    }
 
-    AddPadding(m_imageData, m_imageWidth, m_imageHeight, m_modelData, m_modelWidth, m_modelHeight,
-               0);
+    // Mix with the most recent finished mask, the previous one stays in place otherwise
+    auto mask = m_worker.AcquireMask();
+    if (mask != nullptr) {
+        m_maskFrameIndex = mask->frameIndex;
+        m_maskRegion = mask->region;
+        UpdateTexture(mask->pixels, m_modelWidth, m_modelHeight, m_maskTexture.texture);
+
+        if (m_timeToFirstMask == 0.0) {
+            m_timeToFirstMask = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - m_initializeTime).count();
+            LOGI("Time to first mask %.1f ms\n", m_timeToFirstMask);
+        }
+        if (m_trackRegion) {
+            m_regionTracker.Update(mask->pixels.data() + m_tileOffsetX, m_imageWidth,
+                                   m_imageHeight, m_modelWidth,
+                                   mask->region);
+        }
+        m_worker.ReleaseMask();
+    }
 
-    auto size = m_modelData.size();
-    auto tensorInputIndex = m_pInterpreter->inputs()[0];
-    auto input = m_pInterpreter->typed_tensor<float>(tensorInputIndex);
+    if (m_frameIndex % kStatsLogInterval == 0) {
+        CheckLatencyBudget();
+
+        auto stats = GetStats();
+        LOGI("Queue depth %zu, dropped frames %" PRIu64 ", mask age %" PRIu64 " frame(s), "
+             "%zu bytes copied per frame\n",
+             stats.queueDepth, stats.droppedFrames, stats.maskAge, stats.bytesCopied);
+
+        // Rates over the last logging interval, the first interval has no start time
+        auto now = std::chrono::steady_clock::now();
+        auto seconds = std::chrono::duration<double>(now - m_statsTime).count();
+        auto inferredFrames = stats.inferredFrames - m_statsInferredFrames;
+        auto skippedFrames = stats.skippedFrames - m_statsSkippedFrames;
+        if (m_frameIndex > kStatsLogInterval && inferredFrames + skippedFrames > 0) {
+            LOGI("Inference rate %.1f/s, skip ratio %.1f%%\n",
+                 static_cast<double>(inferredFrames) / seconds,
+                 100.0 * static_cast<double>(skippedFrames) /
+                 static_cast<double>(inferredFrames + skippedFrames));
+        }
+        auto glCalls = GLState::Instance().Counts();
+        if (m_frameIndex > kStatsLogInterval) {
+            LOGI("GL calls per frame %.1f, %.1f redundant ones skipped\n",
+                 static_cast<double>(glCalls.issued - m_statsGLCalls.issued) / kStatsLogInterval,
+                 static_cast<double>(glCalls.skipped - m_statsGLCalls.skipped) /
+                 kStatsLogInterval);
+        }
 
-    for (auto i = 0; i < size; i++) {
-        float f = m_modelData[i];
-        input[i] = (f - 127.5f) / 127.5f;
+        m_statsTime = now;
+        m_statsInferredFrames = stats.inferredFrames;
+        m_statsSkippedFrames = stats.skippedFrames;
+        m_statsGLCalls = glCalls;
     }
+}
 
-    Invoke();
+auto CameraVirtualBackgroundProcessor::SetMaskRefinement(bool enabled) -> void {
+    m_refineMask = enabled;
+}
 
-    auto tensorOutputIndex = m_pInterpreter->outputs()[0];
-    auto data = (float *) m_pInterpreter->tensor(tensorOutputIndex)->data.data;
-    auto rgb = (RGB *) m_modelData.data();
+auto CameraVirtualBackgroundProcessor::SetBackgroundBlur(float strength) -> void {
+    const auto wasSegmenting = IsSegmenting();
+    const auto wasBlurred = m_blurStrength > 0.0f;
+    m_blurStrength = std::max(strength, 0.0f);
+    const auto blurred = m_blurStrength > 0.0f;
+    if (blurred) {
+        m_blur.SetStrength(m_blurStrength);
+    }
 
-    for (int i = 0; i < m_modelHeight; i++) {
-        for (int j = 0; j < m_modelWidth; j++) {
-            // Get the probability value for the person class (assuming it's the first class)
-            float personProbability = data[i * m_modelWidth + j];
+    // SetParams() configures the output for the first time
+    if (m_outputWidth == 0) {
+        return;
+    }
 
-            // Set the pixel color based on the probability threshold (e.g., 0.5)
-            if (personProbability > 0.5) {
-                rgb[j + i * m_modelWidth] = {255, 0, 0};  // Person color
-            } else {
-                rgb[j + i * m_modelWidth] = {0};  // Background color
-            }
+    if (IsSegmenting() != wasSegmenting) {
+        ConfigureOutput(m_outputWidth, m_outputHeight);
+    } else if (blurred != wasBlurred) {
+        // Segmenting over the bitmap either way, only the blur levels come or go
+        if (blurred) {
+            m_blur.Allocate(m_texturePool, m_frameWidth, m_frameHeight);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            GLState::Instance().Reset();
+        } else {
+            m_blur.Release(m_texturePool);
         }
     }
+}
+
+auto CameraVirtualBackgroundProcessor::SetInferenceSchedule(float motionThreshold,
+                                                            int32_t maxSkippedFrames) -> void {
+    m_scheduler.SetThresholds(motionThreshold, maxSkippedFrames);
+}
 
-    RemovePadding(m_modelData, m_modelWidth, m_modelHeight, m_imageData, m_imageWidth,
-                  m_imageHeight);
+auto CameraVirtualBackgroundProcessor::SetRegionOfInterest(bool enabled) -> void {
+    m_trackRegion = enabled;
+    if (!enabled) {
+        m_regionTracker.Reset();
+    }
+}
 
-    UpdateTexture(m_imageData, m_imageWidth, m_imageHeight, m_maskTexture);
+auto CameraVirtualBackgroundProcessor::GetStats() const -> ProcessorStats {
+    return {
+            m_pixelReader.Latency(),
+            m_worker.QueueDepth(),
+            m_worker.DroppedFrames(),
+            m_frameIndex - m_maskFrameIndex,
+            m_copiedBytes.load(),
+            m_scheduler.InferredFrames(),
+            m_scheduler.SkippedFrames(),
+            m_timeToFirstMask,
+            m_texturePool.Allocations(),
+            m_texturePool.Reuses(),
+            m_pModel->name
+    };
+}
+
+auto CameraVirtualBackgroundProcessor::Flush() -> void {
+    m_worker.WaitIdle();
 }
 
 auto CameraVirtualBackgroundProcessor::Mix(int32_t width,
                                            int32_t height,
                                            GLuint vertexBuffer,
-                                           GLuint textureId) const -> void {
-    glViewport(0, 0, width, height);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, m_outputFramebuffer);
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, textureId);
-
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, m_backgroundTexture);
+                                           GLuint textureId,
+                                           GLuint backgroundTexture) const -> void {
+    GL_PASS("Mix");
 
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, m_maskTexture);
+    auto &state = GLState::Instance();
+    state.Viewport(0, 0, width, height);
+    state.BindFramebuffer(m_outputFramebuffer);
 
-    glUseProgram(m_mixProgram);
+    // The texture units match SetMixSamplers()
+    state.BindTexture(0, GL_TEXTURE_2D, textureId);
+    state.BindTexture(1, GL_TEXTURE_2D, backgroundTexture);
+    state.BindTexture(2, GL_TEXTURE_2D, m_maskTexture.texture);
 
-    glUniform1i(glGetUniformLocation(m_mixProgram, "uTexture"), 0);  // 0 = GL_TEXTURE0
-    glUniform1i(glGetUniformLocation(m_mixProgram, "uBackgroundTexture"), 1);  // 1 = GL_TEXTURE1
-    glUniform1i(glGetUniformLocation(m_mixProgram, "uMaskTexture"), 2);  // 2 = GL_TEXTURE2
+    state.UseProgram(m_refineMask ? m_refineMixProgram : m_mixProgram);
+    glUniform4f(m_refineMask ? m_refineMixMaskRegion : m_mixMaskRegion, m_maskRegion.x,
+                m_maskRegion.y, m_maskRegion.width, m_maskRegion.height);
 
-    glVertexAttribPointer(m_mixPosition, 4, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat),
-                          (const GLvoid *) (0 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(m_mixPosition);
-    glVertexAttribPointer(m_mixTexCoord, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat),
-                          (const GLvoid *) (4 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(m_mixTexCoord);
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-    glDrawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_SHORT, VertexIndices());
-
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    state.BindQuad(vertexBuffer);
+    state.DrawQuad();
 }
 
 auto CameraVirtualBackgroundProcessor::VertexResizerShaderCode() -> const char * {
     static const char vertexShader[] =
             "attribute vec4 aPosition;\n"
             "attribute vec4 aTexCoord;\n"
+            // Part of the frame rendered into the model tile, see MaskRegion
+            "uniform vec4 uRegion;\n"
             "varying vec2 vTexCoord;\n"
             "void main() {\n"
             "    gl_Position = aPosition;\n"
-            "    vTexCoord = aTexCoord.xy;\n"
+            "    vTexCoord = uRegion.xy + aTexCoord.xy * uRegion.zw;\n"
             "}\n";
 
     return vertexShader;
@@ -448,12 +632,57 @@ auto CameraVirtualBackgroundProcessor::FragmentMixerShaderCode() -> const char *
             "uniform sampler2D uTexture;\n"
             "uniform sampler2D uMaskTexture;\n"
             "uniform sampler2D uBackgroundTexture;\n"
+            "uniform vec4 uMaskRegion;\n"
+            // The mask is the letterboxed model tile: scale and offset of the image part in it,
+            // and the texel centers at its edges
+            "uniform vec4 uMaskTile;\n"
+            "uniform vec4 uMaskBounds;\n"
             "varying vec2 vTexCoord;\n"
+            "vec2 TileCoord(vec2 maskCoord) {\n"
+            "    return maskCoord * uMaskTile.xy + uMaskTile.zw;\n"
+            "}\n"
+            "float SampleMask(vec2 tileCoord) {\n"
+            "    return texture2D(uMaskTexture, clamp(tileCoord, uMaskBounds.xy, uMaskBounds.zw)).r;\n"
+            "}\n"
+            "#ifdef REFINE_MASK\n"
+            "uniform vec2 uMaskSize;\n"
+            "uniform float uRangeScale;\n"
+            "const vec3 kLuma = vec3(0.299, 0.587, 0.114);\n"
+            // Joint bilateral upsampling: the bilinear weight of every mask neighbour is scaled
+            // down by the luminance difference between the pixel and the neighbour, see MaskRefiner
+            "float RefineMask(vec2 maskCoord, float luma) {\n"
+            "    vec2 texel = maskCoord * uMaskSize - 0.5;\n"
+            "    vec2 base = floor(texel);\n"
+            "    vec2 fraction = texel - base;\n"
+            "    float numerator = 0.0;\n"
+            "    float denominator = 0.0;\n"
+            "    for (int i = 0; i < 4; i++) {\n"
+            "        vec2 offset = vec2(mod(float(i), 2.0), floor(float(i) / 2.0));\n"
+            "        vec2 coord = (base + offset + 0.5) / uMaskSize;\n"
+            "        vec2 frameCoord = uMaskRegion.xy + (coord - uMaskTile.zw) / uMaskTile.xy * uMaskRegion.zw;\n"
+            "        float guide = dot(texture2D(uTexture, vec2(frameCoord.x, 1.0 - frameCoord.y)).rgb, kLuma);\n"
+            "        float difference = luma - guide;\n"
+            "        vec2 bilinear = mix(1.0 - fraction, fraction, offset);\n"
+            "        float weight = bilinear.x * bilinear.y / (1.0 + difference * difference * uRangeScale);\n"
+            "        numerator += weight * SampleMask(coord);\n"
+            "        denominator += weight;\n"
+            "    }\n"
+            "    return numerator / denominator;\n"
+            "}\n"
+            "#endif\n"
             "void main() {\n"
             "    vec4 backgroundColor = texture2D(uBackgroundTexture, vec2(vTexCoord.x, 1.0 - vTexCoord.y));\n"
-            "    vec4 maskColor = texture2D(uMaskTexture, vec2(vTexCoord.x, 1.0 - vTexCoord.y));\n"
             "    vec4 inputColor = texture2D(uTexture, vTexCoord);\n"
-            "    gl_FragColor = mix(backgroundColor, inputColor, maskColor.r);\n"
+            // The mask covers uMaskRegion of the frame, everything outside is background
+            "    vec2 maskCoord = (vec2(vTexCoord.x, 1.0 - vTexCoord.y) - uMaskRegion.xy) / uMaskRegion.zw;\n"
+            "    vec2 inside = step(vec2(0.0), maskCoord) * step(maskCoord, vec2(1.0));\n"
+            "#ifdef REFINE_MASK\n"
+            "    float mask = RefineMask(TileCoord(maskCoord), dot(inputColor.rgb, kLuma));\n"
+            "#else\n"
+            "    float mask = SampleMask(TileCoord(maskCoord));\n"
+            "#endif\n"
+            "    mask *= inside.x * inside.y;\n"
+            "    gl_FragColor = mix(backgroundColor, inputColor, mask);\n"
             "}\n";
 
     return fragmentShader;
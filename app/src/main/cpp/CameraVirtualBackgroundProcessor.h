@@ -16,9 +16,39 @@
 
 #pragma once
 
+#include "BackgroundBlur.h"
+#include "GLUtils.h"
+#include "InferenceScheduler.h"
+#include "InferenceWorker.h"
+#include "ModelRegistry.h"
+#include "PixelReader.h"
+#include "RegionTracker.h"
+#include "Segmenter.h"
+
 #include <GLES2/gl2.h>
-#include <android/asset_manager.h>
-#include <tensorflow/lite/interpreter.h>
+
+#include <atomic>
+#include <chrono>
+
+struct ProcessorStats {
+    int32_t readbackLatency;
+    size_t queueDepth;
+    uint64_t droppedFrames;
+    uint64_t maskAge;
+    // Bytes moved on the CPU for the last segmented frame: readback, tensor I/O and mask upload
+    size_t bytesCopied;
+    // Frames sent to inference and frames that reused the last mask, see InferenceScheduler
+    uint64_t inferredFrames;
+    uint64_t skippedFrames;
+    // From the start of Initialize to the first mask upload, 0 until then
+    double timeToFirstMask;
+    // Textures created by the GL texture pool and reconfigurations served from it, see
+    // GLTexturePool
+    uint64_t texturesAllocated;
+    uint64_t texturesReused;
+    // Registry name of the running model, see SelectModel()
+    const char *modelName;
+};
 
 class CameraVirtualBackgroundProcessor {
 public:
@@ -26,27 +56,83 @@ public:
 
     ~CameraVirtualBackgroundProcessor();
 
-    auto Initialize(AAssetManager *assetManager, GLuint outputTexture) -> void;
+    // loadModel opens the registry model files, see ModelRegistry, it is kept for SelectModel().
+    auto Initialize(const ModelLoader &loadModel, GLuint outputTexture,
+                    const InferenceOptions &options) -> void;
 
     auto SetParams(int32_t width, int32_t height, GLuint backgroundTexture,
                    GLuint framebuffer) -> void;
 
     auto Process(int width, int height, GLuint vertexBuffer) -> void;
 
+    auto GetStats() const -> ProcessorStats;
+
+    // Blocks until the worker finished every submitted frame, so the next Process() mixes with
+    // the mask of the newest one. Makes the output deterministic for tests, stalls the frame for
+    // a whole inference otherwise.
+    auto Flush() -> void;
+
+    // Inference runs when the motion metric of the downscaled frame reaches motionThreshold, or
+    // after maxSkippedFrames frames reusing the last mask, see InferenceScheduler.
+    auto SetInferenceSchedule(float motionThreshold, int32_t maxSkippedFrames) -> void;
+
+    // Segments only the region around the person found in the previous mask instead of the whole
+    // frame, see RegionTracker.
+    auto SetRegionOfInterest(bool enabled) -> void;
+
+    // Upsamples the mask guided by the camera frame in the mix pass, see MaskRefiner.
+    auto SetMaskRefinement(bool enabled) -> void;
+
+    // Replaces the background bitmap with the camera frame itself, blurred, see BackgroundBlur
+    // for the strength. 0 goes back to the bitmap, or to the plain camera frame without one.
+    // Reconfigures the output when that starts or stops the segmentation, call on the GL thread.
+    auto SetBackgroundBlur(float strength) -> void;
+
+    // Switches to the registry model with this name, see ModelRegistry. Keeps the current model
+    // and returns false when the new one cannot be loaded.
+    auto SelectModel(const char *name) -> bool;
+
+    // Switches to the next faster model in the registry whenever the recent invoke time goes
+    // over budgetMs, 0 disables it.
+    auto SetLatencyBudget(float budgetMs) -> void;
+
 private:
-    auto Invoke() const -> void;
+    // Returns false for a null pModelFile, an asset that could not be opened.
+    auto LoadModel(const ModelDescriptor &model, std::unique_ptr<ModelFile> pModelFile) -> bool;
+
+    // Segmentation runs for a background bitmap or a blurred background, otherwise the camera
+    // frame goes straight to the output.
+    auto IsSegmenting() const -> bool;
+
+    // Routes the camera frame to the output texture or through the segmentation passes, see
+    // IsSegmenting(), and sizes the textures of the current mode.
+    auto ConfigureOutput(int32_t width, int32_t height) -> void;
+
+    // Sizes everything that depends on the model input for the current frame size and starts
+    // the worker.
+    auto ConfigureModel() -> void;
 
-    auto Resize(GLuint vertexBuffer, GLuint textureId) const -> void;
+    auto CheckLatencyBudget() -> void;
+
+    auto Resize(GLuint vertexBuffer, GLuint textureId, const MaskRegion &region) const -> void;
 
     auto Process() -> void;
 
-    auto Mix(int32_t width, int32_t height, GLuint vertexBuffer, GLuint textureId) const -> void;
+    auto Mix(int32_t width, int32_t height, GLuint vertexBuffer, GLuint textureId,
+             GLuint backgroundTexture) const -> void;
+
+    // Points the samplers of a mix program at their texture units, see Mix().
+    static auto SetMixSamplers(GLuint program) -> void;
+
+    // Tells a mix program where the image sits in the model tile the mask covers.
+    auto SetMaskTile(GLuint program) const -> void;
 
     static auto UpdateTexture(const std::vector<GLubyte> &pixelData, int32_t width, int32_t height,
                               GLuint texture) -> void;
 
-    static auto BindFramebuffer(GLuint framebuffer, GLuint texture,
-                                int32_t width, int32_t height) -> void;
+    auto AllocateOutputTexture(int32_t width, int32_t height) -> void;
+
+    static auto AttachTexture(GLuint framebuffer, GLuint texture) -> void;
 
     static auto VertexResizerShaderCode() -> const char *;
 
@@ -56,26 +142,58 @@ private:
 
     static auto FragmentMixerShaderCode() -> const char *;
 
-    std::unique_ptr<tflite::Interpreter> m_pInterpreter;
+    ModelLoader m_loadModel;
+    InferenceOptions m_options;
+    const ModelDescriptor *m_pModel;
+    float m_latencyBudget;
 
-    std::vector<GLubyte> m_imageData;
-    std::vector<GLubyte> m_modelData;
+    Segmenter m_segmenter;
+    PixelReader m_pixelReader;
+    InferenceWorker m_worker;
+    InferenceScheduler m_scheduler;
+    RegionTracker m_regionTracker;
+    std::atomic<size_t> m_copiedBytes;
 
-    GLuint m_texture;
+    GLTexturePool m_texturePool;
+    PooledTexture m_frameTexture;
     GLuint m_outputFramebuffer;
+    // Java's framebuffer the camera frame is drawn into, see SetParams()
+    GLuint m_cameraFramebuffer;
     GLuint m_outputTexture;
+    int32_t m_outputWidth;
+    int32_t m_outputHeight;
     GLuint m_backgroundTexture;
-    GLuint m_maskTexture;
+    BackgroundBlur m_blur;
+    float m_blurStrength;
+    PooledTexture m_maskTexture;
     GLuint m_resizeProgram;
-    GLint m_resizePosition;
-    GLint m_resizeTexCoord;
-    GLuint m_resizeFramebuffer;
-    GLuint m_resizeTexture;
+    GLint m_resizeRegion;
+    PooledTexture m_resizeTarget;
     GLuint m_mixProgram;
-    GLint m_mixPosition;
-    GLint m_mixTexCoord;
+    GLint m_mixMaskRegion;
+    GLuint m_refineMixProgram;
+    GLint m_refineMixMaskRegion;
+    GLint m_refineMixMaskSize;
+    bool m_refineMask;
+    bool m_trackRegion;
+    // Regions of the frames still in the readback ring, indexed by frame index
+    static constexpr size_t kRegionHistory = 4;
+    MaskRegion m_resizeRegions[kRegionHistory];
+    MaskRegion m_maskRegion;
     int32_t m_modelWidth;
     int32_t m_modelHeight;
     int32_t m_imageWidth;
     int32_t m_imageHeight;
+    // Column of the model tile the image starts at, it starts at the first row
+    int32_t m_tileOffsetX;
+    int32_t m_frameWidth;
+    int32_t m_frameHeight;
+    uint64_t m_frameIndex;
+    uint64_t m_maskFrameIndex;
+    std::chrono::steady_clock::time_point m_initializeTime;
+    double m_timeToFirstMask;
+    std::chrono::steady_clock::time_point m_statsTime;
+    uint64_t m_statsInferredFrames;
+    uint64_t m_statsSkippedFrames;
+    GLCallCounts m_statsGLCalls;
 };
@@ -17,7 +17,11 @@
 #include "GLUtils.h"
 #include "Log.h"
 
+#include <algorithm>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <iterator>
 
 static auto CheckGlError(const char *op) -> void {
     for (auto error = glGetError(); error; error = glGetError()) {
@@ -63,6 +67,8 @@ auto CreateProgram(const char *pVertexSource, const char *pFragmentSource) -> GL
         CheckGlError("glAttachShader");
         glAttachShader(program, pixelShader);
         CheckGlError("glAttachShader");
+        glBindAttribLocation(program, kPositionAttribute, "aPosition");
+        glBindAttribLocation(program, kTexCoordAttribute, "aTexCoord");
         glLinkProgram(program);
         GLint linkStatus = GL_FALSE;
         glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
@@ -118,3 +124,274 @@ auto VertexIndices() -> const GLushort * {
 
     return vertexIndices;
 }
+
+auto GLESMajorVersion() -> int32_t {
+    auto version = reinterpret_cast<const char *>(glGetString(GL_VERSION));
+    int32_t major = 0;
+    int32_t minor = 0;
+    if (version == nullptr || sscanf(version, "OpenGL ES %d.%d", &major, &minor) != 2) {
+        return 2;
+    }
+
+    return major;
+}
+
+// Never a valid name or value, marks state the cache does not know
+static constexpr GLuint kUnknown = 0xffffffff;
+
+GLState::GLState()
+        : m_program(kUnknown),
+          m_framebuffer(kUnknown),
+          m_activeUnit(kUnknown),
+          m_textures(),
+          m_viewport(),
+          m_blending(-1),
+          m_quadBuffer(kUnknown),
+          m_counts() {
+    Reset();
+}
+
+auto GLState::Instance() -> GLState & {
+    static GLState state;
+    return state;
+}
+
+auto GLState::Reset() -> void {
+    m_program = kUnknown;
+    m_framebuffer = kUnknown;
+    m_activeUnit = kUnknown;
+    m_viewport[0] = m_viewport[1] = m_viewport[2] = m_viewport[3] = -1;
+    m_blending = -1;
+    m_quadBuffer = kUnknown;
+    InvalidateTextures();
+}
+
+auto GLState::InvalidateTextures() -> void {
+    for (auto &unit: m_textures) {
+        std::fill(std::begin(unit), std::end(unit), kUnknown);
+    }
+}
+
+template<typename T>
+auto GLState::Skip(T &cached, T value) -> bool {
+    if (cached == value) {
+        m_counts.skipped++;
+        return true;
+    }
+    cached = value;
+    m_counts.issued++;
+    return false;
+}
+
+auto GLState::UseProgram(GLuint program) -> void {
+    if (!Skip(m_program, program)) {
+        glUseProgram(program);
+    }
+}
+
+auto GLState::BindFramebuffer(GLuint framebuffer) -> void {
+    if (!Skip(m_framebuffer, framebuffer)) {
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    }
+}
+
+auto GLState::BindTexture(GLuint unit, GLenum target, GLuint texture) -> void {
+    if (!Skip(m_activeUnit, unit)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    if (unit >= kTextureUnits) {
+        m_counts.issued++;
+        glBindTexture(target, texture);
+        return;
+    }
+
+    auto &cached = m_textures[unit][target == GL_TEXTURE_2D ? 0 : 1];
+    if (!Skip(cached, texture)) {
+        glBindTexture(target, texture);
+    }
+}
+
+auto GLState::Viewport(GLint x, GLint y, GLsizei width, GLsizei height) -> void {
+    if (m_viewport[0] == x && m_viewport[1] == y && m_viewport[2] == width &&
+        m_viewport[3] == height) {
+        m_counts.skipped++;
+        return;
+    }
+
+    m_viewport[0] = x;
+    m_viewport[1] = y;
+    m_viewport[2] = width;
+    m_viewport[3] = height;
+    m_counts.issued++;
+    glViewport(x, y, width, height);
+}
+
+auto GLState::SetBlending(bool enabled) -> void {
+    if (!Skip(m_blending, enabled ? 1 : 0)) {
+        if (enabled) {
+            glEnable(GL_BLEND);
+        } else {
+            glDisable(GL_BLEND);
+        }
+    }
+}
+
+auto GLState::BindQuad(GLuint vertexBuffer) -> void {
+    // Binding the buffer and the five calls of the attribute setup
+    if (m_quadBuffer == vertexBuffer) {
+        m_counts.skipped += 5;
+        return;
+    }
+
+    m_quadBuffer = vertexBuffer;
+    m_counts.issued += 5;
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glVertexAttribPointer(kPositionAttribute, 4, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat),
+                          (const GLvoid *) (0 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(kPositionAttribute);
+    glVertexAttribPointer(kTexCoordAttribute, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat),
+                          (const GLvoid *) (4 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(kTexCoordAttribute);
+}
+
+auto GLState::DrawQuad() -> void {
+    m_counts.issued++;
+    glDrawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_SHORT, VertexIndices());
+}
+
+auto GLState::Counts() const -> GLCallCounts {
+    return m_counts;
+}
+
+GLTexturePool::GLTexturePool()
+        : m_allocations(0),
+          m_reuses(0) {
+}
+
+GLTexturePool::~GLTexturePool() {
+    Clear();
+}
+
+auto GLTexturePool::Acquire(GLsizei width, GLsizei height, GLenum format, GLint filter,
+                            bool renderTarget) -> PooledTexture {
+    auto entry = std::find_if(m_entries.begin(), m_entries.end(), [&](const Entry &candidate) {
+        return !candidate.inUse && candidate.width == width && candidate.height == height &&
+               candidate.format == format;
+    });
+
+    if (entry != m_entries.end()) {
+        m_reuses++;
+        glBindTexture(GL_TEXTURE_2D, entry->object.texture);
+    } else {
+        m_allocations++;
+        entry = m_entries.insert(m_entries.end(), {{0, 0}, width, height, format, false});
+        glGenTextures(1, &entry->object.texture);
+        glBindTexture(GL_TEXTURE_2D, entry->object.texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE,
+                     nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    entry->inUse = true;
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+
+    // A texture acquired as a plain one first gets its framebuffer on the first render target use
+    if (renderTarget) {
+        if (entry->object.framebuffer == 0) {
+            glGenFramebuffers(1, &entry->object.framebuffer);
+            glBindFramebuffer(GL_FRAMEBUFFER, entry->object.framebuffer);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                                   entry->object.texture, 0);
+        } else {
+            glBindFramebuffer(GL_FRAMEBUFFER, entry->object.framebuffer);
+        }
+        return entry->object;
+    }
+    return {entry->object.texture, 0};
+}
+
+auto GLTexturePool::Release(PooledTexture &texture) -> void {
+    for (auto &entry: m_entries) {
+        if (entry.object.texture == texture.texture && texture.texture != 0) {
+            entry.inUse = false;
+            break;
+        }
+    }
+    texture = {0, 0};
+}
+
+auto GLTexturePool::Clear() -> void {
+    for (auto &entry: m_entries) {
+        if (entry.object.framebuffer != 0) {
+            glDeleteFramebuffers(1, &entry.object.framebuffer);
+        }
+        glDeleteTextures(1, &entry.object.texture);
+    }
+    m_entries.clear();
+}
+
+auto GLTexturePool::Allocations() const -> uint64_t {
+    return m_allocations;
+}
+
+auto GLTexturePool::Reuses() const -> uint64_t {
+    return m_reuses;
+}
+
+GLPassTimer::GLPassTimer()
+        : m_enabled(false) {
+}
+
+auto GLPassTimer::Instance() -> GLPassTimer & {
+    static GLPassTimer timer;
+    return timer;
+}
+
+auto GLPassTimer::SetEnabled(bool enabled) -> void {
+    m_enabled = enabled;
+}
+
+auto GLPassTimer::Record(const char *name, double milliseconds) -> void {
+    // A handful of passes, a linear search is all it takes
+    auto pass = std::find_if(m_passes.begin(), m_passes.end(), [name](const GLPassTime &pass) {
+        return strcmp(pass.name, name) == 0;
+    });
+    if (pass == m_passes.end()) {
+        m_passes.push_back({name, 0, 0.0, 0.0});
+        pass = m_passes.end() - 1;
+    }
+
+    pass->count++;
+    pass->totalMs += milliseconds;
+    pass->maxMs = std::max(pass->maxMs, milliseconds);
+}
+
+auto GLPassTimer::Passes() const -> const std::vector<GLPassTime> & {
+    return m_passes;
+}
+
+auto GLPassTimer::Clear() -> void {
+    m_passes.clear();
+}
+
+ScopedGLPass::ScopedGLPass(const char *name)
+        : m_trace(name),
+          m_name(name),
+          m_timed(GLPassTimer::Instance().IsEnabled()) {
+    if (m_timed) {
+        // Whatever was queued before is not part of this pass
+        glFinish();
+        m_start = std::chrono::steady_clock::now();
+    }
+}
+
+ScopedGLPass::~ScopedGLPass() {
+    if (m_timed) {
+        glFinish();
+        GLPassTimer::Instance().Record(m_name, std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - m_start).count());
+    }
+}
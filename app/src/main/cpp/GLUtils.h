@@ -16,8 +16,19 @@
 
 #pragma once
 
+#include "Trace.h"
+
 #include <GLES2/gl2.h>
 
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Attribute locations every program gets at link time, so all of them share one quad setup
+static constexpr GLuint kPositionAttribute = 0;
+static constexpr GLuint kTexCoordAttribute = 1;
+
+// Binds aPosition and aTexCoord to kPositionAttribute and kTexCoordAttribute.
 auto CreateProgram(const char *pVertexSource, const char *pFragmentSource) -> GLuint;
 
 auto DeleteProgram(GLuint &program) -> void;
@@ -25,3 +36,172 @@ auto DeleteProgram(GLuint &program) -> void;
 auto VertexData() -> const GLfloat*;
 
 auto VertexIndices() -> const GLushort*;
+
+auto GLESMajorVersion() -> int32_t;
+
+struct GLCallCounts {
+    // State changes and draws sent to the driver
+    uint64_t issued;
+    // State changes dropped because they would not have changed anything
+    uint64_t skipped;
+};
+
+// Tracks the GL state the per-frame passes touch and drops calls that would not change it. The
+// cache has to see every change of that state: setup code that calls GL directly, and a new
+// context, call Reset() afterwards. Java binds textures between frames (SurfaceTexture, the
+// background bitmap), so texture bindings are forgotten at the start of every frame with
+// InvalidateTextures(). Render thread only.
+class GLState {
+public:
+    static auto Instance() -> GLState &;
+
+    auto Reset() -> void;
+
+    auto InvalidateTextures() -> void;
+
+    auto UseProgram(GLuint program) -> void;
+
+    auto BindFramebuffer(GLuint framebuffer) -> void;
+
+    // Makes unit the active texture unit first if it is not.
+    auto BindTexture(GLuint unit, GLenum target, GLuint texture) -> void;
+
+    auto Viewport(GLint x, GLint y, GLsizei width, GLsizei height) -> void;
+
+    auto SetBlending(bool enabled) -> void;
+
+    // Points kPositionAttribute and kTexCoordAttribute at the VertexData() quad in vertexBuffer.
+    auto BindQuad(GLuint vertexBuffer) -> void;
+
+    auto DrawQuad() -> void;
+
+    auto Counts() const -> GLCallCounts;
+
+private:
+    GLState();
+
+    // Whether the call that would set the cached value to value can be dropped, updates it
+    template<typename T>
+    auto Skip(T &cached, T value) -> bool;
+
+    // Units beyond these are not cached
+    static constexpr GLuint kTextureUnits = 4;
+    // GL_TEXTURE_2D and GL_TEXTURE_EXTERNAL_OES
+    static constexpr size_t kTextureTargets = 2;
+
+    GLuint m_program;
+    GLuint m_framebuffer;
+    GLuint m_activeUnit;
+    GLuint m_textures[kTextureUnits][kTextureTargets];
+    GLint m_viewport[4];
+    GLint m_blending;
+    GLuint m_quadBuffer;
+    GLCallCounts m_counts;
+};
+
+// A texture handed out by GLTexturePool, framebuffer is 0 unless it was acquired as a render target
+struct PooledTexture {
+    GLuint texture;
+    GLuint framebuffer;
+};
+
+// Keeps textures, and the framebuffers rendering into them, keyed by size and format. Released
+// objects stay allocated, so reconfiguring to a size that was used before gets them back without
+// a trip to the driver allocator. Everything is deleted by Clear() or the destructor, which need
+// the context current. Render thread only.
+class GLTexturePool {
+public:
+    GLTexturePool();
+
+    ~GLTexturePool();
+
+    GLTexturePool(const GLTexturePool &) = delete;
+
+    auto operator=(const GLTexturePool &) -> GLTexturePool & = delete;
+
+    // Returns an idle texture of this size and format, allocated with undefined contents when
+    // there is none. format is GL_RGB, GL_RGBA or GL_LUMINANCE, with GL_UNSIGNED_BYTE texels. The
+    // filter and clamp to edge wrapping are set on every acquire. Leaves the texture bound to
+    // GL_TEXTURE_2D and, for a render target, the framebuffer bound.
+    auto Acquire(GLsizei width, GLsizei height, GLenum format, GLint filter,
+                 bool renderTarget) -> PooledTexture;
+
+    // Returns texture to the pool and zeroes it, does nothing for a zeroed one.
+    auto Release(PooledTexture &texture) -> void;
+
+    auto Clear() -> void;
+
+    // Textures created and acquires served by a released one since the pool was created
+    auto Allocations() const -> uint64_t;
+
+    auto Reuses() const -> uint64_t;
+
+private:
+    struct Entry {
+        PooledTexture object;
+        GLsizei width;
+        GLsizei height;
+        GLenum format;
+        bool inUse;
+    };
+
+    std::vector<Entry> m_entries;
+    uint64_t m_allocations;
+    uint64_t m_reuses;
+};
+
+struct GLPassTime {
+    const char *name;
+    uint64_t count;
+    double totalMs;
+    double maxMs;
+};
+
+// Measures the GPU time of every named GL pass, for the harness. Disabled by default, a pass then
+// costs one branch. Enabled, every pass is enclosed in glFinish() calls, so the wall time between
+// them is exactly the GPU work of the pass. That serializes the CPU and the GPU and is only meant
+// for measurements. Render thread only.
+class GLPassTimer {
+public:
+    static auto Instance() -> GLPassTimer &;
+
+    auto SetEnabled(bool enabled) -> void;
+
+    auto IsEnabled() const -> bool {
+        return m_enabled;
+    }
+
+    // name has to outlive the timer, e.g. a string literal.
+    auto Record(const char *name, double milliseconds) -> void;
+
+    // In the order the passes first ran.
+    auto Passes() const -> const std::vector<GLPassTime> &;
+
+    auto Clear() -> void;
+
+private:
+    GLPassTimer();
+
+    bool m_enabled;
+    std::vector<GLPassTime> m_passes;
+};
+
+// TRACE_SCOPE for a GL pass, also measured by GLPassTimer when that is enabled.
+class ScopedGLPass {
+public:
+    explicit ScopedGLPass(const char *name);
+
+    ~ScopedGLPass();
+
+    ScopedGLPass(const ScopedGLPass &) = delete;
+
+    auto operator=(const ScopedGLPass &) -> ScopedGLPass & = delete;
+
+private:
+    ScopedTrace m_trace;
+    const char *m_name;
+    bool m_timed;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+#define GL_PASS(name) ScopedGLPass TRACE_CONCAT(glPass, __LINE__)(name)
@@ -16,12 +16,20 @@
 
 #pragma once
 
-#include <android/log.h>
-
 #define DEBUG 1
 
 #define  LOG_TAG "native-lib"
+
+#ifdef __ANDROID__
+#include <android/log.h>
+
 #define LOG(severity, ...) ((void)__android_log_print(ANDROID_LOG_##severity, LOG_TAG, __VA_ARGS__))
+#else
+#include <cstdio>
+
+// The segmentation core is also built for desktop Linux, where logs go to stderr
+#define LOG(severity, ...) ((void)fprintf(stderr, LOG_TAG " " #severity ": " __VA_ARGS__))
+#endif
 
 #define LOGE(...) LOG(ERROR, __VA_ARGS__)
 #if DEBUG
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ModelAssets.h"
+
+#include "Log.h"
+
+#include <unistd.h>
+
+auto OpenModelAsset(AAssetManager *assetManager,
+                    const char *fileName) -> std::unique_ptr<ModelFile> {
+    AAsset *asset = AAssetManager_open(assetManager, fileName, AASSET_MODE_RANDOM);
+    if (asset == nullptr) {
+        LOGE("Could not open asset %s\n", fileName);
+        return nullptr;
+    }
+
+    auto pModelFile = std::make_unique<ModelFile>();
+
+    // Uncompressed assets are mapped straight from the APK, compressed ones have to be copied
+    off64_t offset = 0;
+    off64_t length = 0;
+    auto fd = AAsset_openFileDescriptor64(asset, &offset, &length);
+    auto mapped = false;
+    if (fd >= 0) {
+        mapped = pModelFile->Map(fd, static_cast<off_t>(offset), static_cast<size_t>(length));
+        close(fd);
+    }
+
+    if (!mapped) {
+        auto buffer = AAsset_getBuffer(asset);
+        if (buffer == nullptr) {
+            LOGE("Could not read asset %s\n", fileName);
+            AAsset_close(asset);
+            return nullptr;
+        }
+        pModelFile->Copy(buffer, static_cast<size_t>(AAsset_getLength64(asset)));
+    }
+
+    AAsset_close(asset);
+    return pModelFile;
+}
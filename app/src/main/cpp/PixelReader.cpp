@@ -0,0 +1,139 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "PixelReader.h"
+
+#include "GLUtils.h"
+#include "Log.h"
+
+#include <cstring>
+
+// A fence that is kBufferCount - 1 frames old is expected to be signaled already, the timeout
+// only bounds the stall if the GPU falls behind badly.
+static constexpr GLuint64 kFenceTimeoutNs = 100000000;
+
+PixelReader::PixelReader()
+        : m_buffers(),
+          m_fences(),
+          m_width(0),
+          m_height(0),
+          m_size(0),
+          m_frame(0),
+          m_async(false) {
+}
+
+PixelReader::~PixelReader() {
+    Release();
+}
+
+auto PixelReader::Initialize(int32_t width, int32_t height, bool async) -> void {
+    Release();
+
+    m_width = width;
+    m_height = height;
+    m_size = static_cast<size_t>(width) * height * 4;
+    m_frame = 0;
+    m_async = async && GLESMajorVersion() >= 3;
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    if (!m_async) {
+        return;
+    }
+
+    glGenBuffers(kBufferCount, m_buffers.data());
+    for (auto buffer: m_buffers) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(m_size), nullptr,
+                     GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+auto PixelReader::Read(GLubyte *pixels) -> bool {
+    if (!m_async) {
+        if (pixels == nullptr) {
+            return false;
+        }
+        glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        return true;
+    }
+
+    // Queue the readback of the current frame, it completes asynchronously on the GPU
+    auto index = m_frame % kBufferCount;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_buffers[index]);
+    glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    m_fences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_frame++;
+
+    if (m_frame < kBufferCount) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        return false;
+    }
+
+    // Map the oldest buffer of the ring, it was queued kBufferCount - 1 frames ago
+    auto oldest = m_frame % kBufferCount;
+    if (pixels == nullptr) {
+        // Nobody wants this frame, recycle the buffer without mapping it
+        glDeleteSync(m_fences[oldest]);
+        m_fences[oldest] = nullptr;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        return false;
+    }
+
+    glClientWaitSync(m_fences[oldest], GL_SYNC_FLUSH_COMMANDS_BIT, kFenceTimeoutNs);
+    glDeleteSync(m_fences[oldest]);
+    m_fences[oldest] = nullptr;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_buffers[oldest]);
+    auto data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(m_size),
+                                 GL_MAP_READ_BIT);
+    if (data != nullptr) {
+        memcpy(pixels, data, m_size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+        LOGE("Could not map pixel pack buffer (0x%x)\n", glGetError());
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    return data != nullptr;
+}
+
+auto PixelReader::IsAsync() const -> bool {
+    return m_async;
+}
+
+auto PixelReader::FrameSize() const -> size_t {
+    return m_size;
+}
+
+auto PixelReader::Latency() const -> int32_t {
+    return m_async ? kBufferCount - 1 : 0;
+}
+
+auto PixelReader::Release() -> void {
+    for (auto &fence: m_fences) {
+        if (fence != nullptr) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    if (m_buffers[0] != 0) {
+        glDeleteBuffers(kBufferCount, m_buffers.data());
+        m_buffers.fill(0);
+    }
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <GLES3/gl3.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Reads pixels of the currently bound framebuffer. On GLES3 contexts the readback goes through a
+// ring of pixel pack buffers guarded by fences, so the pixels of frame N are mapped while frame
+// N + 1 renders instead of stalling the pipeline in glReadPixels. GLES2 contexts fall back to a
+// synchronous glReadPixels. Pixels are returned as RGBA, the one format every implementation reads
+// without conversion, the alpha channel is dropped by the consumer, see PadAndNormalizeRgba.
+class PixelReader {
+public:
+    PixelReader();
+
+    ~PixelReader();
+
+    // The framebuffer to read from has to be bound.
+    auto Initialize(int32_t width, int32_t height, bool async = true) -> void;
+
+    // Returns false while the ring is still filling up and no pixels are available yet. Passing
+    // nullptr keeps the ring moving but discards the frame that would have been returned.
+    auto Read(GLubyte *pixels) -> bool;
+
+    auto IsAsync() const -> bool;
+
+    // Size in bytes of the pixels returned by Read().
+    auto FrameSize() const -> size_t;
+
+    // Number of frames the returned pixels lag behind the current frame.
+    auto Latency() const -> int32_t;
+
+private:
+    auto Release() -> void;
+
+    static constexpr int32_t kBufferCount = 3;
+
+    std::array<GLuint, kBufferCount> m_buffers;
+    std::array<GLsync, kBufferCount> m_fences;
+    int32_t m_width;
+    int32_t m_height;
+    size_t m_size;
+    uint32_t m_frame;
+    bool m_async;
+};
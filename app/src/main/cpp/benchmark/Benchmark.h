@@ -0,0 +1,132 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Keeps the compiler from optimizing away a computation whose result is otherwise unused.
+template<typename T>
+inline auto DoNotOptimize(const T &value) -> void {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Minimal benchmark runner without external dependencies. Every benchmark body is repeated until
+// it has run for at least the minimum time, the mean time per iteration is reported on stdout and
+// optionally written as JSON (--json=<file>) so results can be compared between commits.
+class BenchmarkRunner {
+public:
+    using Body = std::function<void()>;
+
+    auto Add(const std::string &name, Body body) -> void {
+        m_benchmarks.push_back({name, std::move(body)});
+    }
+
+    auto Run(int argc, char **argv) -> int {
+        std::string filter;
+        std::string jsonPath;
+        auto minTime = 0.5;
+
+        for (int i = 1; i < argc; i++) {
+            if (strncmp(argv[i], "--filter=", 9) == 0) {
+                filter = argv[i] + 9;
+            } else if (strncmp(argv[i], "--json=", 7) == 0) {
+                jsonPath = argv[i] + 7;
+            } else if (strncmp(argv[i], "--min-time=", 11) == 0) {
+                minTime = std::max(atof(argv[i] + 11), 0.01);
+            } else {
+                fprintf(stderr, "Usage: %s [--filter=<substring>] [--json=<file>] "
+                                "[--min-time=<seconds>]\n", argv[0]);
+                return 1;
+            }
+        }
+
+        std::vector<Result> results;
+        printf("%-56s %14s %12s\n", "Benchmark", "Time (us)", "Iterations");
+        for (auto &benchmark: m_benchmarks) {
+            if (!filter.empty() && benchmark.name.find(filter) == std::string::npos) {
+                continue;
+            }
+
+            auto result = Measure(benchmark, minTime);
+            printf("%-56s %14.2f %12lld\n", result.name.c_str(), result.nanoseconds / 1000.0,
+                   static_cast<long long>(result.iterations));
+            results.push_back(result);
+        }
+
+        return jsonPath.empty() || WriteJson(jsonPath, results) ? 0 : 1;
+    }
+
+private:
+    struct Benchmark {
+        std::string name;
+        Body body;
+    };
+
+    struct Result {
+        std::string name;
+        int64_t iterations;
+        double nanoseconds;
+    };
+
+    static auto Measure(Benchmark &benchmark, double minTime) -> Result {
+        using clock = std::chrono::steady_clock;
+
+        // Warm up caches and lazily initialized state
+        benchmark.body();
+
+        int64_t iterations = 0;
+        std::chrono::duration<double> elapsed(0);
+        const auto start = clock::now();
+        while (elapsed.count() < minTime) {
+            benchmark.body();
+            iterations++;
+            elapsed = clock::now() - start;
+        }
+
+        return {benchmark.name, iterations,
+                elapsed.count() * 1e9 / static_cast<double>(iterations)};
+    }
+
+    static auto WriteJson(const std::string &path, const std::vector<Result> &results) -> bool {
+        auto file = fopen(path.c_str(), "w");
+        if (file == nullptr) {
+            fprintf(stderr, "Could not open %s\n", path.c_str());
+            return false;
+        }
+
+        // Same layout as Google Benchmark's JSON reporter, so existing comparison tools work
+        fprintf(file, "{\n  \"benchmarks\": [\n");
+        for (size_t i = 0; i < results.size(); i++) {
+            fprintf(file, "    {\"name\": \"%s\", \"iterations\": %lld, \"real_time\": %.1f, "
+                          "\"cpu_time\": %.1f, \"time_unit\": \"ns\"}%s\n",
+                    results[i].name.c_str(), static_cast<long long>(results[i].iterations),
+                    results[i].nanoseconds, results[i].nanoseconds,
+                    i + 1 < results.size() ? "," : "");
+        }
+        fprintf(file, "  ]\n}\n");
+        fclose(file);
+        return true;
+    }
+
+    std::vector<Benchmark> m_benchmarks;
+};
@@ -0,0 +1,257 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Benchmark.h"
+
+#include "Compositor.h"
+#include "ImageUtils.h"
+#include "MaskRefiner.h"
+#include "ModelRegistry.h"
+#include "Postprocess.h"
+#include "Preprocess.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+static auto RandomBytes(size_t size) -> std::vector<uint8_t> {
+    std::mt19937 generator(42);
+    std::vector<uint8_t> bytes(size);
+    for (auto &byte: bytes) {
+        byte = static_cast<uint8_t>(generator());
+    }
+    return bytes;
+}
+
+struct Size {
+    int32_t width;
+    int32_t height;
+};
+
+static auto Name(const char *kernel, const char *variant, Size size) -> std::string {
+    return std::string(kernel) + "/" + variant + "/" + std::to_string(size.width) + "x" +
+           std::to_string(size.height);
+}
+
+// Model input sizes of the registry's landscape model, its square and multiclass models and a
+// larger model outside the registry
+static const Size kModelSizes[] = {{256, 144}, {256, 256}, {512, 512}};
+
+// Camera frames are 16:9, their image region in the model input is padded at the bottom for
+// square models
+static auto ImageSize(Size modelSize) -> Size {
+    auto [width, height] = ResizeImageToFit(1280, 720, modelSize.width, modelSize.height);
+    return {width, height};
+}
+
+static auto AddFitBenchmarks(BenchmarkRunner &runner) -> void {
+    runner.Add("ResizeImageToFit", [] {
+        int32_t width = 1280;
+        DoNotOptimize(width);
+        DoNotOptimize(ResizeImageToFit(width, 720, 256, 144));
+    });
+}
+
+// Normalization of the image region into the model input, float and uint8 tensors. The app reads
+// back the model tile letterboxed on the GPU, the tile variants normalize that without padding.
+static auto AddNormalizeBenchmarks(BenchmarkRunner &runner) -> void {
+    for (auto modelSize: kModelSizes) {
+        const auto imageSize = ImageSize(modelSize);
+        const auto elements = static_cast<size_t>(modelSize.width) * modelSize.height * 3;
+        auto image = std::make_shared<std::vector<uint8_t>>(
+                RandomBytes(imageSize.width * imageSize.height * 3));
+        auto floatInput = std::make_shared<std::vector<float>>(elements);
+        auto byteInput = std::make_shared<std::vector<uint8_t>>(elements);
+        const Quantization quantization = {1.0f / 128.0f, 128};
+
+        runner.Add(Name("Normalize/float", "simd", modelSize), [=] {
+            PadAndNormalize(image->data(), imageSize.width, imageSize.height, floatInput->data(),
+                            modelSize.width, modelSize.height, 127.5f, 127.5f);
+        });
+        runner.Add(Name("Normalize/float", "scalar", modelSize), [=] {
+            PadAndNormalizeScalar(image->data(), imageSize.width, imageSize.height,
+                                  floatInput->data(), modelSize.width, modelSize.height, 127.5f,
+                                  127.5f);
+        });
+        runner.Add(Name("Normalize/uint8", "simd", modelSize), [=] {
+            PadAndNormalize(image->data(), imageSize.width, imageSize.height, byteInput->data(),
+                            modelSize.width, modelSize.height, 127.5f, 127.5f, quantization);
+        });
+        runner.Add(Name("Normalize/uint8", "scalar", modelSize), [=] {
+            PadAndNormalizeScalar(image->data(), imageSize.width, imageSize.height,
+                                  byteInput->data(), modelSize.width, modelSize.height, 127.5f,
+                                  127.5f, quantization);
+        });
+
+        auto tile = std::make_shared<std::vector<uint8_t>>(RandomBytes(elements));
+        runner.Add(Name("Normalize/float/tile", "simd", modelSize), [=] {
+            PadAndNormalize(tile->data(), modelSize.width, modelSize.height, floatInput->data(),
+                            modelSize.width, modelSize.height, 127.5f, 127.5f);
+        });
+        runner.Add(Name("Normalize/uint8/tile", "simd", modelSize), [=] {
+            PadAndNormalize(tile->data(), modelSize.width, modelSize.height, byteInput->data(),
+                            modelSize.width, modelSize.height, 127.5f, 127.5f, quantization);
+        });
+    }
+}
+
+// The two readback formats of the model tile: RGBA normalized in one pass that drops alpha, as
+// the app does, against RGBA repacked to RGB first, the cost of a GL_RGB readback on drivers
+// that read RGBA only. A native GL_RGB readback costs the tile variants above.
+static auto AddRgbaNormalizeBenchmarks(BenchmarkRunner &runner) -> void {
+    for (auto modelSize: kModelSizes) {
+        const auto pixels = static_cast<size_t>(modelSize.width) * modelSize.height;
+        auto rgba = std::make_shared<std::vector<uint8_t>>(RandomBytes(pixels * 4));
+        auto rgb = std::make_shared<std::vector<uint8_t>>(pixels * 3);
+        auto floatInput = std::make_shared<std::vector<float>>(pixels * 3);
+        auto byteInput = std::make_shared<std::vector<uint8_t>>(pixels * 3);
+        const Quantization quantization = {1.0f / 128.0f, 128};
+
+        runner.Add(Name("Normalize/float/rgba", "simd", modelSize), [=] {
+            PadAndNormalizeRgba(rgba->data(), modelSize.width, modelSize.height,
+                                floatInput->data(), modelSize.width, modelSize.height, 127.5f,
+                                127.5f);
+        });
+        runner.Add(Name("Normalize/float/rgba", "scalar", modelSize), [=] {
+            PadAndNormalizeRgbaScalar(rgba->data(), modelSize.width, modelSize.height,
+                                      floatInput->data(), modelSize.width, modelSize.height,
+                                      127.5f, 127.5f);
+        });
+        runner.Add(Name("Normalize/float/repack", "simd", modelSize), [=] {
+            for (size_t i = 0; i < pixels; i++) {
+                std::copy_n(rgba->data() + i * 4, 3, rgb->data() + i * 3);
+            }
+            PadAndNormalize(rgb->data(), modelSize.width, modelSize.height, floatInput->data(),
+                            modelSize.width, modelSize.height, 127.5f, 127.5f);
+        });
+        runner.Add(Name("Normalize/uint8/rgba", "simd", modelSize), [=] {
+            PadAndNormalizeRgba(rgba->data(), modelSize.width, modelSize.height,
+                                byteInput->data(), modelSize.width, modelSize.height, 127.5f,
+                                127.5f, quantization);
+        });
+        runner.Add(Name("Normalize/uint8/rgba", "scalar", modelSize), [=] {
+            PadAndNormalizeRgbaScalar(rgba->data(), modelSize.width, modelSize.height,
+                                      byteInput->data(), modelSize.width, modelSize.height,
+                                      127.5f, 127.5f, quantization);
+        });
+    }
+}
+
+// Quantization of the person probabilities to the 8-bit mask, single-channel float outputs and
+// the output of the multiclass registry model
+static auto AddQuantizeMaskBenchmarks(BenchmarkRunner &runner) -> void {
+    const auto &model = *FindModel("multiclass");
+    const OutputChannel multiclass = {model.outputChannels, model.personChannel,
+                                      model.invertPerson};
+
+    for (auto modelSize: kModelSizes) {
+        const auto imageSize = ImageSize(modelSize);
+        const auto pixels = static_cast<size_t>(modelSize.width) * modelSize.height;
+        auto probabilities = std::make_shared<std::vector<float>>(pixels * multiclass.channelCount);
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+        for (auto &probability: *probabilities) {
+            probability = distribution(generator);
+        }
+        auto mask = std::make_shared<std::vector<uint8_t>>(imageSize.width * imageSize.height);
+
+        runner.Add(Name("QuantizeMask/float", "simd", modelSize), [=] {
+            QuantizeMask(probabilities->data(), modelSize.width, modelSize.height, mask->data(),
+                         imageSize.width, imageSize.height);
+        });
+        runner.Add(Name("QuantizeMask/float", "scalar", modelSize), [=] {
+            QuantizeMaskScalar(probabilities->data(), modelSize.width, modelSize.height,
+                               mask->data(), imageSize.width, imageSize.height);
+        });
+        runner.Add(Name("QuantizeMask/multiclass", "simd", modelSize), [=] {
+            QuantizeMask(probabilities->data(), modelSize.width, modelSize.height, mask->data(),
+                         imageSize.width, imageSize.height, {}, multiclass);
+        });
+        runner.Add(Name("QuantizeMask/multiclass", "scalar", modelSize), [=] {
+            QuantizeMaskScalar(probabilities->data(), modelSize.width, modelSize.height,
+                               mask->data(), imageSize.width, imageSize.height, {}, multiclass);
+        });
+    }
+}
+
+// Blends camera frames over a background through a 256x144 mask, naive scalar reference against
+// the SIMD compositor on one and four threads
+static auto AddCompositeBenchmarks(BenchmarkRunner &runner) -> void {
+    const Size maskSize = {256, 144};
+
+    for (auto size: {Size{640, 360}, Size{1280, 720}, Size{1920, 1080}}) {
+        auto frame = std::make_shared<std::vector<uint8_t>>(
+                RandomBytes(size.width * size.height * 4));
+        auto background = std::make_shared<std::vector<uint8_t>>(
+                RandomBytes(size.width * size.height * 4));
+        auto mask = std::make_shared<std::vector<uint8_t>>(
+                RandomBytes(maskSize.width * maskSize.height));
+        auto output = std::make_shared<std::vector<uint8_t>>(size.width * size.height * 4);
+
+        runner.Add(Name("Composite", "scalar", size), [=] {
+            Compositor::CompositeScalar(frame->data(), background->data(), mask->data(),
+                                        maskSize.width, maskSize.height, output->data(),
+                                        size.width, size.height);
+        });
+        for (auto threadCount: {1, 4}) {
+            auto compositor = std::make_shared<Compositor>(threadCount);
+            const auto variant = "simd-" + std::to_string(threadCount) + "t";
+            runner.Add(Name("Composite", variant.c_str(), size), [=] {
+                compositor->Composite(frame->data(), background->data(), mask->data(),
+                                      maskSize.width, maskSize.height, output->data(),
+                                      size.width, size.height);
+            });
+        }
+    }
+}
+
+// Refines a 256x144 mask, the landscape image region of a 256x256 model, to camera resolutions
+static auto AddRefinementBenchmarks(BenchmarkRunner &runner) -> void {
+    const Size maskSize = {256, 144};
+
+    for (auto size: {Size{640, 360}, Size{1280, 720}, Size{1920, 1080}}) {
+        auto guide = std::make_shared<std::vector<uint8_t>>(
+                RandomBytes(size.width * size.height * 4));
+        auto mask = std::make_shared<std::vector<uint8_t>>(
+                RandomBytes(maskSize.width * maskSize.height));
+        auto output = std::make_shared<std::vector<uint8_t>>(size.width * size.height);
+        auto refiner = std::make_shared<MaskRefiner>();
+
+        runner.Add(Name("RefineMask", "simd", size), [=] {
+            refiner->Refine(guide->data(), size.width, size.height, mask->data(),
+                            maskSize.width, maskSize.height, output->data());
+        });
+        runner.Add(Name("RefineMask", "scalar", size), [=] {
+            refiner->RefineScalar(guide->data(), size.width, size.height, mask->data(),
+                                  maskSize.width, maskSize.height, output->data());
+        });
+    }
+}
+
+int main(int argc, char **argv) {
+    BenchmarkRunner runner;
+
+    AddFitBenchmarks(runner);
+    AddNormalizeBenchmarks(runner);
+    AddRgbaNormalizeBenchmarks(runner);
+    AddQuantizeMaskBenchmarks(runner);
+    AddCompositeBenchmarks(runner);
+    AddRefinementBenchmarks(runner);
+
+    return runner.Run(argc, argv);
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "EglContext.h"
+
+#include "Log.h"
+
+#include <EGL/eglext.h>
+
+#include <cstring>
+#include <initializer_list>
+
+static auto HasExtension(const char *extensions, const char *name) -> bool {
+    if (extensions == nullptr) {
+        return false;
+    }
+
+    const auto length = strlen(name);
+    for (auto p = strstr(extensions, name); p != nullptr; p = strstr(p + length, name)) {
+        if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+EglContext::EglContext()
+        : m_display(EGL_NO_DISPLAY),
+          m_context(EGL_NO_CONTEXT),
+          m_surface(EGL_NO_SURFACE) {
+}
+
+EglContext::~EglContext() {
+    Release();
+}
+
+auto EglContext::Initialize() -> bool {
+    if (!OpenDisplay()) {
+        LOGE("Could not open an EGL display\n");
+        return false;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_ES_API)) {
+        LOGE("OpenGL ES is not supported by EGL\n");
+        return false;
+    }
+
+    const auto extensions = eglQueryString(m_display, EGL_EXTENSIONS);
+    const auto surfaceless = HasExtension(extensions, "EGL_KHR_surfaceless_context");
+
+    for (auto majorVersion: {3, 2}) {
+        const auto renderableType = majorVersion == 3 ? EGL_OPENGL_ES3_BIT_KHR : EGL_OPENGL_ES2_BIT;
+
+        EGLConfig config = nullptr;
+        auto usePbuffer = ChooseConfig(EGL_PBUFFER_BIT, renderableType, config);
+        if (!usePbuffer && !(surfaceless && ChooseConfig(0, renderableType, config))) {
+            continue;
+        }
+
+        const EGLint contextAttributes[] = {EGL_CONTEXT_CLIENT_VERSION, majorVersion, EGL_NONE};
+        m_context = eglCreateContext(m_display, config, EGL_NO_CONTEXT, contextAttributes);
+        if (m_context == EGL_NO_CONTEXT) {
+            continue;
+        }
+
+        if (usePbuffer) {
+            const EGLint surfaceAttributes[] = {EGL_WIDTH, 16, EGL_HEIGHT, 16, EGL_NONE};
+            m_surface = eglCreatePbufferSurface(m_display, config, surfaceAttributes);
+        }
+
+        if (eglMakeCurrent(m_display, m_surface, m_surface, m_context)) {
+            return true;
+        }
+
+        LOGE("Could not make the OpenGL ES %d context current (0x%x)\n", majorVersion,
+             eglGetError());
+        Release();
+        if (!OpenDisplay()) {
+            return false;
+        }
+    }
+
+    LOGE("No OpenGL ES context available\n");
+    return false;
+}
+
+auto EglContext::Release() -> void {
+    if (m_display == EGL_NO_DISPLAY) {
+        return;
+    }
+
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (m_surface != EGL_NO_SURFACE) {
+        eglDestroySurface(m_display, m_surface);
+        m_surface = EGL_NO_SURFACE;
+    }
+    if (m_context != EGL_NO_CONTEXT) {
+        eglDestroyContext(m_display, m_context);
+        m_context = EGL_NO_CONTEXT;
+    }
+    eglTerminate(m_display);
+    m_display = EGL_NO_DISPLAY;
+}
+
+auto EglContext::OpenDisplay() -> bool {
+    // Client extensions are queried without a display
+    const auto clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (HasExtension(clientExtensions, "EGL_MESA_platform_surfaceless") &&
+        HasExtension(clientExtensions, "EGL_EXT_platform_base")) {
+        auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+                eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (getPlatformDisplay != nullptr) {
+            m_display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY,
+                                           nullptr);
+            if (m_display != EGL_NO_DISPLAY && eglInitialize(m_display, nullptr, nullptr)) {
+                return true;
+            }
+        }
+    }
+
+    m_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (m_display != EGL_NO_DISPLAY && eglInitialize(m_display, nullptr, nullptr)) {
+        return true;
+    }
+
+    m_display = EGL_NO_DISPLAY;
+    return false;
+}
+
+auto EglContext::ChooseConfig(EGLint surfaceType, EGLint renderableType,
+                              EGLConfig &config) const -> bool {
+    const EGLint attributes[] = {
+            EGL_SURFACE_TYPE, surfaceType,
+            EGL_RENDERABLE_TYPE, renderableType,
+            EGL_RED_SIZE, 8,
+            EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE, 8,
+            EGL_ALPHA_SIZE, 8,
+            EGL_NONE
+    };
+
+    EGLint count = 0;
+    return eglChooseConfig(m_display, attributes, &config, 1, &count) && count > 0;
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <EGL/egl.h>
+
+// Offscreen OpenGL ES context for the harness. Prefers the Mesa surfaceless platform, which needs
+// neither a display server nor a GPU (llvmpipe), and falls back to the default display. Everything
+// renders into framebuffer objects, the pbuffer only exists to make the context current where
+// surfaceless contexts are not supported.
+class EglContext {
+public:
+    EglContext();
+
+    ~EglContext();
+
+    EglContext(const EglContext &) = delete;
+
+    auto operator=(const EglContext &) -> EglContext & = delete;
+
+    // Creates an OpenGL ES 3 context, or 2 when 3 is not available, and makes it current.
+    auto Initialize() -> bool;
+
+    auto Release() -> void;
+
+private:
+    auto OpenDisplay() -> bool;
+
+    auto ChooseConfig(EGLint surfaceType, EGLint renderableType, EGLConfig &config) const -> bool;
+
+    EGLDisplay m_display;
+    EGLContext m_context;
+    EGLSurface m_surface;
+};
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GLCallCounter.h"
+
+#include <GLES3/gl3.h>
+
+// GL is only called from the harness thread
+static uint64_t g_callCount = 0;
+
+auto GLCallCount() -> uint64_t {
+    return g_callCount;
+}
+
+// Keep in sync with GL_COUNTED_FUNCTIONS in CMakeLists.txt
+#define GL_COUNTED(result, name, parameters, arguments) \
+    extern "C" result __real_##name parameters;         \
+    extern "C" result __wrap_##name parameters {        \
+        g_callCount++;                                  \
+        return __real_##name arguments;                 \
+    }
+
+GL_COUNTED(void, glActiveTexture, (GLenum texture), (texture))
+GL_COUNTED(void, glBindBuffer, (GLenum target, GLuint buffer), (target, buffer))
+GL_COUNTED(void, glBindFramebuffer, (GLenum target, GLuint framebuffer), (target, framebuffer))
+GL_COUNTED(void, glBindTexture, (GLenum target, GLuint texture), (target, texture))
+GL_COUNTED(void, glClear, (GLbitfield mask), (mask))
+GL_COUNTED(void, glClearColor, (GLfloat r, GLfloat g, GLfloat b, GLfloat a), (r, g, b, a))
+GL_COUNTED(GLenum, glClientWaitSync, (GLsync sync, GLbitfield flags, GLuint64 timeout),
+           (sync, flags, timeout))
+GL_COUNTED(void, glDeleteSync, (GLsync sync), (sync))
+GL_COUNTED(void, glDisable, (GLenum cap), (cap))
+GL_COUNTED(void, glDrawElements, (GLenum mode, GLsizei count, GLenum type, const void *indices),
+           (mode, count, type, indices))
+GL_COUNTED(void, glEnable, (GLenum cap), (cap))
+GL_COUNTED(void, glEnableVertexAttribArray, (GLuint index), (index))
+GL_COUNTED(GLsync, glFenceSync, (GLenum condition, GLbitfield flags), (condition, flags))
+GL_COUNTED(void, glGetIntegerv, (GLenum name, GLint *data), (name, data))
+GL_COUNTED(GLint, glGetUniformLocation, (GLuint program, const GLchar *name), (program, name))
+GL_COUNTED(GLboolean, glIsFramebuffer, (GLuint framebuffer), (framebuffer))
+GL_COUNTED(GLboolean, glIsTexture, (GLuint texture), (texture))
+GL_COUNTED(void *, glMapBufferRange,
+           (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access),
+           (target, offset, length, access))
+GL_COUNTED(void, glPixelStorei, (GLenum name, GLint value), (name, value))
+GL_COUNTED(void, glReadPixels,
+           (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type,
+            void *pixels), (x, y, width, height, format, type, pixels))
+GL_COUNTED(void, glTexImage2D,
+           (GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height,
+            GLint border, GLenum format, GLenum type, const void *pixels),
+           (target, level, internalFormat, width, height, border, format, type, pixels))
+GL_COUNTED(void, glTexParameteri, (GLenum target, GLenum name, GLint value),
+           (target, name, value))
+GL_COUNTED(void, glTexSubImage2D,
+           (GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height,
+            GLenum format, GLenum type, const void *pixels),
+           (target, level, x, y, width, height, format, type, pixels))
+GL_COUNTED(void, glUniform1f, (GLint location, GLfloat x), (location, x))
+GL_COUNTED(void, glUniform1i, (GLint location, GLint x), (location, x))
+GL_COUNTED(void, glUniform2f, (GLint location, GLfloat x, GLfloat y), (location, x, y))
+GL_COUNTED(void, glUniform4f, (GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w),
+           (location, x, y, z, w))
+GL_COUNTED(void, glUniformMatrix4fv,
+           (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value),
+           (location, count, transpose, value))
+GL_COUNTED(GLboolean, glUnmapBuffer, (GLenum target), (target))
+GL_COUNTED(void, glUseProgram, (GLuint program), (program))
+GL_COUNTED(void, glVertexAttribPointer,
+           (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride,
+            const void *pointer), (index, size, type, normalized, stride, pointer))
+GL_COUNTED(void, glViewport, (GLint x, GLint y, GLsizei width, GLsizei height),
+           (x, y, width, height))
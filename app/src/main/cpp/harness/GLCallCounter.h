@@ -0,0 +1,24 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+// Number of GL calls made so far by the code linked into the harness. Every GL function the
+// pipeline calls per frame is wrapped at link time (--wrap, see CMakeLists.txt), so counting
+// needs no changes to the pipeline. glFinish() is left out, GLPassTimer adds those.
+auto GLCallCount() -> uint64_t;
@@ -0,0 +1,592 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CameraSurfaceTexture.h"
+#include "EglContext.h"
+#include "GLCallCounter.h"
+#include "GLUtils.h"
+#include "GoldenImage.h"
+#include "ModelRegistry.h"
+#include "Preprocess.h"
+#include "Trace.h"
+
+#include <GLES2/gl2.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
+
+// Frames of a static scene before its output is captured, enough for the readback ring, the
+// temporal filter and the region tracker to settle
+static constexpr int32_t kSettleFrames = 12;
+
+// Output pixels may differ from the golden by a few levels between drivers and CPUs, a golden
+// fails when more than this fraction of the pixels differs by more than the tolerance
+static constexpr double kMaxMismatchRatio = 0.005;
+
+static constexpr int32_t kBackgroundWidth = 640;
+static constexpr int32_t kBackgroundHeight = 360;
+
+// Frame size of the model switching checks, small to keep them fast
+static constexpr int32_t kModelCheckWidth = 160;
+static constexpr int32_t kModelCheckHeight = 90;
+
+// More than two latency budget checks, the processor runs one every 300 frames
+static constexpr int32_t kBudgetCheckFrames = 601;
+
+struct Options {
+    std::string assets = "app/src/main/assets";
+    std::string goldens;
+    std::string output;
+    std::string tracePath;
+    bool updateGoldens = false;
+    int32_t width = 1280;
+    int32_t height = 720;
+    int32_t frames = 300;
+    int32_t threadCount = 2;
+    int32_t tolerance = 8;
+    float blurStrength = 0.0f;
+};
+
+// A person-like figure in front of a textured background, personX in [0, 1] of the frame width.
+// blurStrength 0 composites over the background bitmap, see SetBackgroundBlur().
+struct Scene {
+    const char *name;
+    float personX;
+    bool refineMask;
+    float blurStrength;
+};
+
+static const Scene kScenes[] = {
+        {"center", 0.5f, true, 0.0f},
+        {"left", 0.3f, true, 0.0f},
+        {"right-unrefined", 0.7f, false, 0.0f},
+        {"blur", 0.5f, true, 2.0f},
+};
+
+static const Scene &kBlurScene = kScenes[3];
+
+static auto Usage(const char *program) -> int {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "Runs the GL pipeline headless on synthetic frames, compares the output against\n"
+            "golden images and times every GL pass.\n"
+            "  --assets=<dir>       model assets, default app/src/main/assets\n"
+            "  --goldens=<dir>      compare the output against <dir>/<scene>.ppm.gz\n"
+            "  --update-goldens     write the goldens instead of comparing\n"
+            "  --output=<dir>       also write the output of every scene there\n"
+            "  --size=<width>x<height>  frame size, default 1280x720\n"
+            "  --frames=<count>     timed frames, default 300\n"
+            "  --threads=<count>    interpreter threads, default 2\n"
+            "  --tolerance=<levels> per-channel golden tolerance, default 8\n"
+            "  --blur=<strength>    blur the background of the timed frames, default 0 (off)\n"
+            "  --trace=<file.json>  write a Chrome trace of the timed frames\n", program);
+    return 1;
+}
+
+static auto ParseOptions(int argc, char **argv, Options &options) -> bool {
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--assets=", 9) == 0) {
+            options.assets = argv[i] + 9;
+        } else if (strncmp(argv[i], "--goldens=", 10) == 0) {
+            options.goldens = argv[i] + 10;
+        } else if (strcmp(argv[i], "--update-goldens") == 0) {
+            options.updateGoldens = true;
+        } else if (strncmp(argv[i], "--output=", 9) == 0) {
+            options.output = argv[i] + 9;
+        } else if (strncmp(argv[i], "--size=", 7) == 0) {
+            if (sscanf(argv[i] + 7, "%dx%d", &options.width, &options.height) != 2) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "--frames=", 9) == 0) {
+            options.frames = atoi(argv[i] + 9);
+        } else if (strncmp(argv[i], "--threads=", 10) == 0) {
+            options.threadCount = atoi(argv[i] + 10);
+        } else if (strncmp(argv[i], "--tolerance=", 12) == 0) {
+            options.tolerance = atoi(argv[i] + 12);
+        } else if (strncmp(argv[i], "--blur=", 7) == 0) {
+            options.blurStrength = static_cast<float>(atof(argv[i] + 7));
+        } else if (strncmp(argv[i], "--trace=", 8) == 0) {
+            options.tracePath = argv[i] + 8;
+        } else {
+            return false;
+        }
+    }
+
+    return options.width > 0 && options.height > 0 && options.frames >= 0 &&
+           (!options.updateGoldens || !options.goldens.empty());
+}
+
+// RGBA, rows top to bottom like a camera image
+static auto DrawFrame(std::vector<uint8_t> &frame, int32_t width, int32_t height,
+                      float personX) -> void {
+    const auto headX = personX * static_cast<float>(width);
+    const auto headY = 0.3f * static_cast<float>(height);
+    const auto headRadius = 0.12f * static_cast<float>(height);
+    const auto bodyTop = 0.45f * static_cast<float>(height);
+    const auto bodyHalfWidth = 0.2f * static_cast<float>(height);
+
+    for (int32_t y = 0; y < height; y++) {
+        auto row = frame.data() + static_cast<size_t>(y) * width * 4;
+        const auto fy = static_cast<float>(y);
+        for (int32_t x = 0; x < width; x++) {
+            const auto fx = static_cast<float>(x);
+            const auto dx = fx - headX;
+            const auto dy = fy - headY;
+
+            // Shoulders widen towards the bottom of the frame
+            const auto bodyWidth = bodyHalfWidth * (1.0f + (fy - bodyTop) / (2.0f * bodyTop));
+            uint8_t r, g, b;
+            if (dx * dx + dy * dy < headRadius * headRadius) {
+                r = 224, g = 172, b = 140;
+            } else if (fy > bodyTop && std::fabs(dx) < bodyWidth) {
+                r = 40, g = 80, b = 160;
+            } else {
+                // Shelves and a wall gradient, enough structure for the refinement to bite on
+                const auto shelf = (y / 48) % 4 == 0;
+                r = static_cast<uint8_t>(shelf ? 120 : 180 + x * 60 / width);
+                g = static_cast<uint8_t>(shelf ? 90 : 170 + y * 40 / height);
+                b = static_cast<uint8_t>(shelf ? 60 : 150);
+            }
+
+            row[x * 4 + 0] = r;
+            row[x * 4 + 1] = g;
+            row[x * 4 + 2] = b;
+            row[x * 4 + 3] = 255;
+        }
+    }
+}
+
+static auto DrawBackground(std::vector<uint8_t> &background) -> void {
+    for (int32_t y = 0; y < kBackgroundHeight; y++) {
+        for (int32_t x = 0; x < kBackgroundWidth; x++) {
+            auto pixel = background.data() + (static_cast<size_t>(y) * kBackgroundWidth + x) * 4;
+            const auto checker = ((x / 40) + (y / 40)) % 2 == 0;
+            pixel[0] = checker ? 30 : 200;
+            pixel[1] = static_cast<uint8_t>(60 + y * 120 / kBackgroundHeight);
+            pixel[2] = checker ? 220 : 40;
+            pixel[3] = 255;
+        }
+    }
+}
+
+static auto UploadTexture(GLuint texture, const std::vector<uint8_t> &pixels, int32_t width,
+                          int32_t height) -> void {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                 pixels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// The output texture is upright with the first row at the bottom, like every GL texture
+static auto ReadTexture(GLuint texture, int32_t width, int32_t height) -> RgbImage {
+    GLuint framebuffer = 0;
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+
+    std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+
+    RgbImage image;
+    image.width = width;
+    image.height = height;
+    image.pixels.resize(static_cast<size_t>(width) * height * 3);
+    for (int32_t y = 0; y < height; y++) {
+        auto src = rgba.data() + static_cast<size_t>(height - 1 - y) * width * 4;
+        auto dst = image.pixels.data() + static_cast<size_t>(y) * width * 3;
+        for (int32_t x = 0; x < width; x++) {
+            std::copy(src + x * 4, src + x * 4 + 3, dst + x * 3);
+        }
+    }
+    return image;
+}
+
+// Times the readback of a model tile, like PixelReader reads it from the resize target, plus the
+// normalization into a float input tensor, in GL_RGBA and in GL_RGB where the implementation
+// reads that without conversion
+static auto CompareReadbackFormats(const ModelDescriptor &model, int32_t repeats) -> void {
+    using clock = std::chrono::steady_clock;
+
+    GLuint texture = 0;
+    GLuint framebuffer = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, model.width, model.height, 0, GL_RGB,
+                 GL_UNSIGNED_BYTE, nullptr);
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+
+    GLint readFormat = 0;
+    GLint readType = 0;
+    glGetIntegerv(GL_IMPLEMENTATION_COLOR_READ_FORMAT, &readFormat);
+    glGetIntegerv(GL_IMPLEMENTATION_COLOR_READ_TYPE, &readType);
+
+    const auto pixelCount = static_cast<size_t>(model.width) * model.height;
+    std::vector<uint8_t> pixels(pixelCount * 4);
+    std::vector<float> input(pixelCount * 3);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+    char title[32];
+    snprintf(title, sizeof(title), "readback %dx%d", model.width, model.height);
+    fprintf(stderr, "\n%-26s %10s %12s\n", title, "read ms", "normalize ms");
+    const GLenum formats[] = {GL_RGBA, GL_RGB};
+    for (auto format: formats) {
+        const auto name = format == GL_RGBA ? "GL_RGBA" : "GL_RGB";
+        if (format == GL_RGB && (readFormat != GL_RGB || readType != GL_UNSIGNED_BYTE)) {
+            fprintf(stderr, "%-26s not the implementation read format\n", name);
+            continue;
+        }
+
+        double readMs = 0.0;
+        double normalizeMs = 0.0;
+        for (int32_t i = 0; i < repeats; i++) {
+            glClearColor(static_cast<float>(i % 256) / 255.0f, 0.5f, 0.25f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            glFinish();
+
+            auto start = clock::now();
+            glReadPixels(0, 0, model.width, model.height, format, GL_UNSIGNED_BYTE,
+                         pixels.data());
+            auto read = clock::now();
+            if (format == GL_RGBA) {
+                PadAndNormalizeRgba(pixels.data(), model.width, model.height, input.data(),
+                                    model.width, model.height, model.mean, model.stddev);
+            } else {
+                PadAndNormalize(pixels.data(), model.width, model.height, input.data(),
+                                model.width, model.height, model.mean, model.stddev);
+            }
+            auto end = clock::now();
+
+            readMs += std::chrono::duration<double, std::milli>(read - start).count();
+            normalizeMs += std::chrono::duration<double, std::milli>(end - read).count();
+        }
+        fprintf(stderr, "%-26s %10.3f %12.3f\n", name, readMs / repeats, normalizeMs / repeats);
+    }
+
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(1, &texture);
+    GLState::Instance().Reset();
+}
+
+// Returns false when the output does not match the golden
+static auto CheckGolden(const Options &options, const char *name, const RgbImage &image) -> bool {
+    if (!options.output.empty()) {
+        WritePpm(options.output + "/" + name + ".ppm", image);
+    }
+    if (options.goldens.empty()) {
+        return true;
+    }
+
+    const auto path = options.goldens + "/" + name + ".ppm.gz";
+    if (options.updateGoldens) {
+        if (!WritePpm(path, image)) {
+            fprintf(stderr, "%-16s could not write %s\n", name, path.c_str());
+            return false;
+        }
+        fprintf(stderr, "%-16s golden written\n", name);
+        return true;
+    }
+
+    RgbImage golden;
+    if (!ReadPpm(path, golden)) {
+        fprintf(stderr, "%-16s FAIL: no golden %s\n", name, path.c_str());
+        return false;
+    }
+    if (golden.width != image.width || golden.height != image.height) {
+        fprintf(stderr, "%-16s FAIL: golden is %dx%d, output %dx%d\n", name, golden.width,
+                golden.height, image.width, image.height);
+        return false;
+    }
+
+    const auto difference = CompareImages(image, golden, options.tolerance);
+    const auto passed = difference.mismatchRatio <= kMaxMismatchRatio;
+    fprintf(stderr, "%-16s %s: max difference %d, mean %.3f, %.3f%% over tolerance\n", name,
+            passed ? "ok" : "FAIL", difference.maxDifference, difference.meanDifference,
+            difference.mismatchRatio * 100.0);
+    return passed;
+}
+
+static auto ExpectModel(const CameraVirtualBackgroundProcessor &processor, const char *check,
+                        const char *expected) -> bool {
+    const auto model = processor.GetStats().modelName;
+    const auto passed = strcmp(model, expected) == 0;
+    fprintf(stderr, "%-16s %s: running %s, expected %s\n", check, passed ? "ok" : "FAILED", model,
+            expected);
+    return passed;
+}
+
+// Returns the number of failed checks. renderFrame(i) draws frame i of a moving scene. Needs the
+// file of every registry model under assets, skipped otherwise.
+static auto CheckModelSwitching(CameraVirtualBackgroundProcessor &processor,
+                                const std::string &assets,
+                                const std::function<void(int32_t)> &renderFrame) -> int32_t {
+    for (size_t i = 0; i < ModelCount(); i++) {
+        const auto path = assets + "/" + Models()[i].path;
+        auto file = fopen(path.c_str(), "rb");
+        if (file == nullptr) {
+            fprintf(stderr, "%-16s skipped: no %s\n", "models", path.c_str());
+            return 0;
+        }
+        fclose(file);
+    }
+
+    // No model meets this budget: the processor moves to the next faster model at every check
+    // until it runs the cheapest one, then turns the budget off and stays there
+    auto failures = 0;
+    const auto cheapest = Models()[ModelCount() - 1].name;
+    processor.SetLatencyBudget(std::numeric_limits<float>::min());
+    for (int32_t i = 0; i < kBudgetCheckFrames; i++) {
+        renderFrame(i);
+    }
+    failures += ExpectModel(processor, "budget", cheapest) ? 0 : 1;
+    for (int32_t i = 0; i < kBudgetCheckFrames; i++) {
+        renderFrame(i);
+    }
+    failures += ExpectModel(processor, "budget off", cheapest) ? 0 : 1;
+
+    for (size_t i = 0; i < ModelCount(); i++) {
+        const auto name = Models()[i].name;
+        if (!processor.SelectModel(name)) {
+            fprintf(stderr, "%-16s FAILED: could not select %s\n", "select", name);
+            failures++;
+            continue;
+        }
+        for (int32_t frame = 0; frame < kSettleFrames; frame++) {
+            renderFrame(frame);
+            processor.Flush();
+        }
+        failures += ExpectModel(processor, "select", name) ? 0 : 1;
+    }
+
+    const auto current = processor.GetStats().modelName;
+    if (processor.SelectModel("unknown")) {
+        fprintf(stderr, "%-16s FAILED: selected an unknown model\n", "select");
+        failures++;
+    }
+    failures += ExpectModel(processor, "select unknown", current) ? 0 : 1;
+    return failures;
+}
+
+int main(int argc, char **argv) {
+    using clock = std::chrono::steady_clock;
+
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        return Usage(argv[0]);
+    }
+
+    EglContext context;
+    if (!context.Initialize()) {
+        return 1;
+    }
+    fprintf(stderr, "%s, %s\n", reinterpret_cast<const char *>(glGetString(GL_RENDERER)),
+            reinterpret_cast<const char *>(glGetString(GL_VERSION)));
+
+    const auto assets = options.assets;
+    ModelLoader loadModel = [assets](const char *path) -> std::unique_ptr<ModelFile> {
+        auto pModelFile = std::make_unique<ModelFile>();
+        if (!pModelFile->Map((assets + "/" + path).c_str())) {
+            fprintf(stderr, "Could not map %s/%s\n", assets.c_str(), path);
+            return nullptr;
+        }
+        return pModelFile;
+    };
+
+    // The processor starts with the square model and has no way to report a failed load
+    if (!loadModel(FindModel("square")->path)) {
+        return 1;
+    }
+
+    const auto width = options.width;
+    const auto height = options.height;
+
+    GLuint textures[3];
+    glGenTextures(3, textures);
+    const auto inputTexture = textures[0];
+    const auto outputTexture = textures[1];
+    const auto backgroundTexture = textures[2];
+
+    std::vector<uint8_t> background(static_cast<size_t>(kBackgroundWidth) * kBackgroundHeight * 4);
+    DrawBackground(background);
+    UploadTexture(backgroundTexture, background, kBackgroundWidth, kBackgroundHeight);
+
+    InferenceOptions inferenceOptions;
+    inferenceOptions.threadCount = options.threadCount;
+
+    auto pSurfaceTexture = CameraSurfaceTexture::create();
+    pSurfaceTexture->Initialize(loadModel, inputTexture, outputTexture, inferenceOptions,
+                                GL_TEXTURE_2D);
+    pSurfaceTexture->SetParams(width, height, backgroundTexture);
+    auto &processor = pSurfaceTexture->Processor();
+
+    // SurfaceTexture hands out a vertical flip for camera frames, the frames here are stored the
+    // same way
+    float transformMatrix[16] = {1, 0, 0, 0, 0, -1, 0, 0, 0, 0, 1, 0, 0, 1, 0, 1};
+    float rotationMatrix[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+    // Goldens: static scenes, the worker is flushed after every frame so the output does not
+    // depend on how fast inference runs
+    std::vector<uint8_t> frame(static_cast<size_t>(width) * height * 4);
+    const auto renderScene = [&](const Scene &scene) {
+        processor.SetMaskRefinement(scene.refineMask);
+        processor.SetBackgroundBlur(scene.blurStrength);
+        DrawFrame(frame, width, height, scene.personX);
+        UploadTexture(inputTexture, frame, width, height);
+
+        for (int32_t i = 0; i < kSettleFrames; i++) {
+            pSurfaceTexture->UpdateTexImage(transformMatrix, rotationMatrix);
+            processor.Flush();
+        }
+        return CheckGolden(options, scene.name, ReadTexture(outputTexture, width, height));
+    };
+    auto failures = 0;
+    for (const auto &scene: kScenes) {
+        if (!renderScene(scene)) {
+            failures++;
+        }
+    }
+
+    // Reconfiguring to a size used before reuses the pooled textures and renders the same
+    pSurfaceTexture->SetParams(height, width, backgroundTexture);
+    const auto allocated = processor.GetStats().texturesAllocated;
+    pSurfaceTexture->SetParams(width, height, backgroundTexture);
+    const auto poolStats = processor.GetStats();
+    fprintf(stderr, "reconfigure      %s: %" PRIu64 " texture(s) allocated, %" PRIu64 " reused\n",
+            poolStats.texturesAllocated == allocated ? "ok" : "FAILED",
+            poolStats.texturesAllocated, poolStats.texturesReused);
+    if (poolStats.texturesAllocated != allocated) {
+        failures++;
+    }
+    if (!options.updateGoldens && !renderScene(kScenes[0])) {
+        failures++;
+    }
+
+    // The blurred background needs no bitmap: turning the blur on switches from the plain camera
+    // frame to segmentation, with the same output as over the bitmap
+    pSurfaceTexture->SetParams(width, height, 0);
+    if (!options.updateGoldens && !renderScene(kBlurScene)) {
+        failures++;
+    }
+    pSurfaceTexture->SetParams(width, height, backgroundTexture);
+
+    // Model switching, on a swaying person so that inference keeps running
+    if (!options.updateGoldens) {
+        std::vector<uint8_t> smallFrame(static_cast<size_t>(kModelCheckWidth) *
+                                        kModelCheckHeight * 4);
+        const auto renderFrame = [&](int32_t i) {
+            DrawFrame(smallFrame, kModelCheckWidth, kModelCheckHeight,
+                      0.5f + 0.15f * std::sin(static_cast<float>(i) * 0.1f));
+            UploadTexture(inputTexture, smallFrame, kModelCheckWidth, kModelCheckHeight);
+            pSurfaceTexture->UpdateTexImage(transformMatrix, rotationMatrix);
+        };
+        pSurfaceTexture->SetParams(kModelCheckWidth, kModelCheckHeight, backgroundTexture);
+        failures += CheckModelSwitching(processor, options.assets, renderFrame);
+        processor.SelectModel("square");
+        pSurfaceTexture->SetParams(width, height, backgroundTexture);
+    }
+
+    // Timing: a swaying person, inference runs asynchronously like in the app
+    processor.SetMaskRefinement(true);
+    processor.SetBackgroundBlur(options.blurStrength);
+    auto &timer = GLPassTimer::Instance();
+    timer.SetEnabled(true);
+    if (!options.tracePath.empty()) {
+        Tracer::Instance().SetEnabled(true);
+    }
+
+    std::vector<double> frameTimes;
+    uint64_t glCalls = 0;
+    const auto stateCountsBefore = GLState::Instance().Counts();
+    for (int32_t i = 0; i < options.frames; i++) {
+        DrawFrame(frame, width, height, 0.5f + 0.15f * std::sin(static_cast<float>(i) * 0.1f));
+        UploadTexture(inputTexture, frame, width, height);
+
+        glFinish();
+        const auto start = clock::now();
+        const auto callsBefore = GLCallCount();
+        pSurfaceTexture->UpdateTexImage(transformMatrix, rotationMatrix);
+        glCalls += GLCallCount() - callsBefore;
+        glFinish();
+        frameTimes.push_back(std::chrono::duration<double, std::milli>(clock::now() - start)
+                                     .count());
+    }
+    timer.SetEnabled(false);
+
+    if (!frameTimes.empty()) {
+        fprintf(stderr, "\n%dx%d, %zu frames\n%-20s %8s %10s %10s\n", width, height,
+                frameTimes.size(), "pass", "count", "mean ms", "max ms");
+        for (const auto &pass: timer.Passes()) {
+            fprintf(stderr, "%-20s %8" PRIu64 " %10.3f %10.3f\n", pass.name, pass.count,
+                    pass.totalMs / static_cast<double>(pass.count), pass.maxMs);
+        }
+
+        std::sort(frameTimes.begin(), frameTimes.end());
+        double sum = 0.0;
+        for (auto time: frameTimes) {
+            sum += time;
+        }
+        fprintf(stderr, "%-20s %8zu %10.3f %10.3f\n", "frame", frameTimes.size(),
+                sum / static_cast<double>(frameTimes.size()), frameTimes.back());
+
+        const auto frameCount = static_cast<double>(frameTimes.size());
+        const auto stateCounts = GLState::Instance().Counts();
+        fprintf(stderr, "GL calls per frame %.1f, %.1f redundant state changes skipped\n",
+                static_cast<double>(glCalls) / frameCount,
+                static_cast<double>(stateCounts.skipped - stateCountsBefore.skipped) / frameCount);
+
+        auto stats = processor.GetStats();
+        fprintf(stderr, "inferred %" PRIu64 ", skipped %" PRIu64 ", dropped %" PRIu64 "\n",
+                stats.inferredFrames, stats.skippedFrames, stats.droppedFrames);
+
+        CompareReadbackFormats(*FindModel("square"), static_cast<int32_t>(frameTimes.size()));
+    }
+
+    if (!options.tracePath.empty() && !Tracer::Instance().WriteChromeTrace(options.tracePath)) {
+        fprintf(stderr, "Could not write %s\n", options.tracePath.c_str());
+        return 1;
+    }
+
+    // The pipeline owns GL objects, it goes before the context
+    pSurfaceTexture.reset();
+    glDeleteTextures(3, textures);
+
+    if (failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GoldenImage.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+#include <zlib.h>
+
+// Reads a decimal header field and the whitespace in front of it, -1 when there is none
+static auto ReadHeaderValue(gzFile file) -> int32_t {
+    auto c = gzgetc(file);
+    while (c != -1 && isspace(c)) {
+        c = gzgetc(file);
+    }
+
+    int32_t value = -1;
+    while (c != -1 && isdigit(c) && value < 65536) {
+        value = std::max(value, 0) * 10 + (c - '0');
+        c = gzgetc(file);
+    }
+    // A single whitespace character ends the field
+    return c != -1 && isspace(c) ? value : -1;
+}
+
+auto ReadPpm(const std::string &path, RgbImage &image) -> bool {
+    auto file = gzopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    auto ok = gzgetc(file) == 'P' && gzgetc(file) == '6';
+    const auto width = ok ? ReadHeaderValue(file) : -1;
+    const auto height = width > 0 ? ReadHeaderValue(file) : -1;
+    ok = height > 0 && ReadHeaderValue(file) == 255;
+    if (ok) {
+        image.width = width;
+        image.height = height;
+        image.pixels.resize(static_cast<size_t>(width) * height * 3);
+        ok = gzread(file, image.pixels.data(), static_cast<unsigned>(image.pixels.size())) ==
+             static_cast<int>(image.pixels.size());
+    }
+
+    gzclose(file);
+    return ok;
+}
+
+auto WritePpm(const std::string &path, const RgbImage &image) -> bool {
+    // "T" writes without compression
+    const auto compressed = path.size() > 3 && path.compare(path.size() - 3, 3, ".gz") == 0;
+    auto file = gzopen(path.c_str(), compressed ? "wb9" : "wbT");
+    if (file == nullptr) {
+        return false;
+    }
+
+    auto ok = gzprintf(file, "P6\n%d %d\n255\n", image.width, image.height) > 0 &&
+              gzwrite(file, image.pixels.data(), static_cast<unsigned>(image.pixels.size())) ==
+              static_cast<int>(image.pixels.size());
+    return gzclose(file) == Z_OK && ok;
+}
+
+auto CompareImages(const RgbImage &image, const RgbImage &reference,
+                   int32_t tolerance) -> ImageDifference {
+    int32_t maxDifference = 0;
+    uint64_t sum = 0;
+    size_t mismatches = 0;
+
+    const auto pixelCount = image.pixels.size() / 3;
+    for (size_t i = 0; i < pixelCount; i++) {
+        int32_t pixelDifference = 0;
+        for (size_t c = 0; c < 3; c++) {
+            auto difference = std::abs(static_cast<int32_t>(image.pixels[i * 3 + c]) -
+                                       static_cast<int32_t>(reference.pixels[i * 3 + c]));
+            pixelDifference = std::max(pixelDifference, difference);
+            sum += static_cast<uint64_t>(difference);
+        }
+        maxDifference = std::max(maxDifference, pixelDifference);
+        mismatches += pixelDifference > tolerance ? 1 : 0;
+    }
+
+    const auto count = static_cast<double>(std::max<size_t>(pixelCount, 1));
+    return {maxDifference, static_cast<double>(sum) / (count * 3.0),
+            static_cast<double>(mismatches) / count};
+}
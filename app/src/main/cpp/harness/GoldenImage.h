@@ -0,0 +1,45 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 3-channel image, rows top to bottom.
+struct RgbImage {
+    int32_t width = 0;
+    int32_t height = 0;
+    std::vector<uint8_t> pixels;
+};
+
+struct ImageDifference {
+    int32_t maxDifference;
+    double meanDifference;
+    // Fraction of the pixels with a channel differing by more than the tolerance
+    double mismatchRatio;
+};
+
+// Binary PPM (P6) with 8-bit channels. Compressed files are read transparently.
+auto ReadPpm(const std::string &path, RgbImage &image) -> bool;
+
+// Compresses with gzip when the path ends in .gz.
+auto WritePpm(const std::string &path, const RgbImage &image) -> bool;
+
+// Both images must have the same size.
+auto CompareImages(const RgbImage &image, const RgbImage &reference,
+                   int32_t tolerance) -> ImageDifference;
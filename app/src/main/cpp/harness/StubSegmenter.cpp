@@ -0,0 +1,104 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Stands in for Segmenter.cpp in gl-harness-stub. The mask is keyed on the colors of the
+// synthetic frames, see DrawFrame() in GLHarness.cpp, so the output only depends on the GL
+// pipeline and the goldens stay valid across models and TensorFlow Lite builds. The model file
+// is kept but never interpreted.
+
+#include "Segmenter.h"
+
+#include "Trace.h"
+
+#include <chrono>
+
+#include <tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h>
+
+// Weight of the latest call in RecentInvokeTime(), same as the real segmenter
+static constexpr float kRecentInvokeWeight = 0.1f;
+
+Segmenter::Segmenter()
+        : m_pDelegate(nullptr, TfLiteXNNPackDelegateDelete),
+          m_preprocess(nullptr),
+          m_preprocessRgba(nullptr),
+          m_postprocess(nullptr),
+          m_mean(0.0f),
+          m_stddev(1.0f),
+          m_filterRegion(RegionTracker::kFullFrame),
+          m_width(0),
+          m_height(0),
+          m_copiedBytes(0),
+          m_invokeCount(0),
+          m_invokeTime(0),
+          m_recentInvokeTime(0.0f) {
+}
+
+Segmenter::~Segmenter() = default;
+
+auto Segmenter::Initialize(std::unique_ptr<ModelFile> pModelFile, const ModelDescriptor &model,
+                           const InferenceOptions &) -> bool {
+    m_pModelFile = std::move(pModelFile);
+    m_width = model.width;
+    m_height = model.height;
+    m_invokeCount = 0;
+    m_recentInvokeTime.store(0.0f, std::memory_order_relaxed);
+    return true;
+}
+
+auto Segmenter::Width() const -> int32_t {
+    return m_width;
+}
+
+auto Segmenter::Height() const -> int32_t {
+    return m_height;
+}
+
+// The shirt is the only blue above the 150 of the wall, the face the only red above 200 with
+// less blue than the wall. Bilinear blends at the edges fall on either side of the thresholds.
+static auto IsPerson(const uint8_t *pixel) -> bool {
+    return pixel[2] > 155 || (pixel[2] < 145 && pixel[0] > 200);
+}
+
+auto Segmenter::Segment(const std::vector<uint8_t> &image, int32_t imageWidth,
+                        int32_t imageHeight, int32_t channels, const MaskRegion &,
+                        std::vector<uint8_t> &mask) -> void {
+    TRACE_SCOPE("Invoke");
+    const auto start = std::chrono::steady_clock::now();
+
+    const auto pixels = static_cast<size_t>(imageWidth) * imageHeight;
+    for (size_t i = 0; i < pixels; i++) {
+        mask[i] = IsPerson(&image[i * channels]) ? 255 : 0;
+    }
+    m_copiedBytes = pixels;
+
+    const auto time = std::chrono::duration<float, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+    const auto recent = m_recentInvokeTime.load(std::memory_order_relaxed);
+    m_recentInvokeTime.store(++m_invokeCount == 1 ? time :
+                             recent + kRecentInvokeWeight * (time - recent),
+                             std::memory_order_relaxed);
+}
+
+auto Segmenter::ResetTemporalFilter() -> void {
+}
+
+auto Segmenter::CopiedBytes() const -> size_t {
+    return m_copiedBytes;
+}
+
+auto Segmenter::RecentInvokeTime() const -> float {
+    return m_recentInvokeTime.load(std::memory_order_relaxed);
+}
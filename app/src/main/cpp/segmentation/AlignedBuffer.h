@@ -0,0 +1,56 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+
+// Heap buffer with a guaranteed start alignment, e.g. for tensors handed to TensorFlow Lite as
+// custom allocations, which have to be aligned to 64 bytes.
+class AlignedBuffer {
+public:
+    static constexpr size_t kDefaultAlignment = 64;
+
+    AlignedBuffer() : m_pData(nullptr, &free), m_size(0) {
+    }
+
+    auto Allocate(size_t size, size_t alignment = kDefaultAlignment) -> void {
+        // aligned_alloc wants the size to be a multiple of the alignment
+        auto capacity = (size + alignment - 1) / alignment * alignment;
+        m_pData.reset(static_cast<uint8_t *>(aligned_alloc(alignment, capacity)));
+        m_size = m_pData ? size : 0;
+    }
+
+    auto Data() const -> uint8_t * {
+        return m_pData.get();
+    }
+
+    auto Size() const -> size_t {
+        return m_size;
+    }
+
+    template<typename T>
+    auto As() const -> T * {
+        return reinterpret_cast<T *>(m_pData.get());
+    }
+
+private:
+    std::unique_ptr<uint8_t, decltype(&free)> m_pData;
+    size_t m_size;
+};
@@ -0,0 +1,269 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Compositor.h"
+
+#include <algorithm>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Mask values of a row are computed this many pixels at a time, then blended
+static constexpr int32_t kChunkSize = 64;
+
+using BlendFunction = void (*)(const uint8_t *frame, const uint8_t *background,
+                               const uint8_t *alpha, uint8_t *output, int32_t count);
+
+// out = (frame * a + background * (255 - a)) / 255, rounded, on every channel including alpha
+static auto BlendScalar(const uint8_t *frame, const uint8_t *background, const uint8_t *alpha,
+                        uint8_t *output, int32_t count) -> void {
+    for (int32_t i = 0; i < count * 4; i++) {
+        const auto a = static_cast<uint32_t>(alpha[i / 4]);
+        const auto t = frame[i] * a + background[i] * (255 - a) + 128;
+        output[i] = static_cast<uint8_t>((t + (t >> 8)) >> 8);
+    }
+}
+
+#if defined(__ARM_NEON)
+
+static auto BlendNeon(const uint8_t *frame, const uint8_t *background, const uint8_t *alpha,
+                      uint8_t *output, int32_t count) -> void {
+    const auto round = vdupq_n_u16(128);
+
+    auto i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const auto fg = vld4_u8(frame + i * 4);
+        const auto bg = vld4_u8(background + i * 4);
+        const auto a = vld1_u8(alpha + i);
+        const auto inverse = vmvn_u8(a);
+
+        uint8x8x4_t result;
+        for (int c = 0; c < 4; c++) {
+            auto t = vaddq_u16(vmlal_u8(vmull_u8(fg.val[c], a), bg.val[c], inverse), round);
+            result.val[c] = vshrn_n_u16(vsraq_n_u16(t, t, 8), 8);
+        }
+        vst4_u8(output + i * 4, result);
+    }
+
+    BlendScalar(frame + i * 4, background + i * 4, alpha + i, output + i * 4, count - i);
+}
+
+static auto SelectBlend() -> BlendFunction {
+    return BlendNeon;
+}
+
+#elif defined(__x86_64__) || defined(__i386__)
+
+static auto BlendSse2(const uint8_t *frame, const uint8_t *background, const uint8_t *alpha,
+                      uint8_t *output, int32_t count) -> void {
+    const auto zero = _mm_setzero_si128();
+    const auto full = _mm_set1_epi16(255);
+    const auto round = _mm_set1_epi16(128);
+
+    auto i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const auto fg = _mm_loadu_si128(reinterpret_cast<const __m128i *>(frame + i * 4));
+        const auto bg = _mm_loadu_si128(reinterpret_cast<const __m128i *>(background + i * 4));
+
+        // a0 a0 a0 a0 a1 a1 a1 a1 ..., one alpha per channel
+        int32_t packed;
+        std::copy_n(alpha + i, 4, reinterpret_cast<uint8_t *>(&packed));
+        auto a = _mm_cvtsi32_si128(packed);
+        a = _mm_unpacklo_epi8(a, a);
+        a = _mm_unpacklo_epi16(a, a);
+
+        __m128i halves[2];
+        for (int h = 0; h < 2; h++) {
+            const auto weight = h == 0 ? _mm_unpacklo_epi8(a, zero) : _mm_unpackhi_epi8(a, zero);
+            const auto f = h == 0 ? _mm_unpacklo_epi8(fg, zero) : _mm_unpackhi_epi8(fg, zero);
+            const auto b = h == 0 ? _mm_unpacklo_epi8(bg, zero) : _mm_unpackhi_epi8(bg, zero);
+            auto t = _mm_add_epi16(_mm_mullo_epi16(f, weight),
+                                   _mm_mullo_epi16(b, _mm_sub_epi16(full, weight)));
+            t = _mm_add_epi16(t, round);
+            halves[h] = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output + i * 4),
+                         _mm_packus_epi16(halves[0], halves[1]));
+    }
+
+    BlendScalar(frame + i * 4, background + i * 4, alpha + i, output + i * 4, count - i);
+}
+
+__attribute__((target("avx2")))
+static auto BlendAvx2(const uint8_t *frame, const uint8_t *background, const uint8_t *alpha,
+                      uint8_t *output, int32_t count) -> void {
+    const auto full = _mm256_set1_epi16(255);
+    const auto round = _mm256_set1_epi16(128);
+    const auto spreadLow = _mm_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+    const auto spreadHigh = _mm_setr_epi8(4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7);
+
+    auto i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const auto a = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(alpha + i));
+
+        __m256i halves[2];
+        for (int h = 0; h < 2; h++) {
+            const auto offset = (i + h * 4) * 4;
+            const auto weight = _mm256_cvtepu8_epi16(
+                    _mm_shuffle_epi8(a, h == 0 ? spreadLow : spreadHigh));
+            const auto f = _mm256_cvtepu8_epi16(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i *>(frame + offset)));
+            const auto b = _mm256_cvtepu8_epi16(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i *>(background + offset)));
+            auto t = _mm256_add_epi16(_mm256_mullo_epi16(f, weight),
+                                      _mm256_mullo_epi16(b, _mm256_sub_epi16(full, weight)));
+            t = _mm256_add_epi16(t, round);
+            halves[h] = _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+        }
+
+        // packus works within 128-bit lanes, restore the pixel order afterwards
+        const auto packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(halves[0], halves[1]),
+                                                     _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + i * 4), packed);
+    }
+
+    BlendScalar(frame + i * 4, background + i * 4, alpha + i, output + i * 4, count - i);
+}
+
+static auto SelectBlend() -> BlendFunction {
+    if (__builtin_cpu_supports("avx2")) {
+        return BlendAvx2;
+    }
+    return BlendSse2;
+}
+
+#else
+
+static auto SelectBlend() -> BlendFunction {
+    return BlendScalar;
+}
+
+#endif
+
+Compositor::Compositor(int32_t threadCount)
+        : m_pool(threadCount),
+          m_width(0),
+          m_maskWidth(0) {
+}
+
+auto Compositor::SetThreadCount(int32_t threadCount) -> void {
+    m_pool.Resize(threadCount);
+}
+
+auto Compositor::Composite(const uint8_t *frame, const uint8_t *background, const uint8_t *mask,
+                           int32_t maskWidth, int32_t maskHeight, uint8_t *output, int32_t width,
+                           int32_t height) -> void {
+    static const auto blend = SelectBlend();
+
+    Prepare(width, maskWidth);
+
+    const auto scaleY = static_cast<float>(maskHeight) / static_cast<float>(height);
+    const auto stride = static_cast<size_t>(width) * 4;
+    const auto columns = m_columns.data();
+    const auto weightsX = m_weightsX.data();
+
+    m_pool.ParallelFor(height, [=](int32_t begin, int32_t end) {
+        // Mask row interpolated vertically, in 1/256, the last value repeats as the right
+        // neighbour of the last column
+        std::vector<int32_t> maskRow(maskWidth + 1);
+        uint8_t alpha[kChunkSize];
+
+        for (auto y = begin; y < end; y++) {
+            const auto my = std::min(std::max((y + 0.5f) * scaleY - 0.5f, 0.0f),
+                                     static_cast<float>(maskHeight - 1));
+            const auto y0 = static_cast<int32_t>(my);
+            const auto y1 = std::min(y0 + 1, maskHeight - 1);
+            const auto wy = static_cast<int32_t>((my - static_cast<float>(y0)) * 256.0f + 0.5f);
+            const auto top = mask + static_cast<size_t>(y0) * maskWidth;
+            const auto bottom = mask + static_cast<size_t>(y1) * maskWidth;
+            for (int32_t x = 0; x < maskWidth; x++) {
+                maskRow[x] = top[x] * (256 - wy) + bottom[x] * wy;
+            }
+            maskRow[maskWidth] = maskRow[maskWidth - 1];
+            const auto offset = static_cast<size_t>(y) * stride;
+
+            for (int32_t x0 = 0; x0 < width; x0 += kChunkSize) {
+                const auto count = std::min(kChunkSize, width - x0);
+                for (int32_t i = 0; i < count; i++) {
+                    const auto left = maskRow[columns[x0 + i]];
+                    const auto right = maskRow[columns[x0 + i] + 1];
+                    alpha[i] = static_cast<uint8_t>(
+                            (left * 256 + (right - left) * weightsX[x0 + i] + 32768) >> 16);
+                }
+                blend(frame + offset + x0 * 4, background + offset + x0 * 4, alpha,
+                      output + offset + x0 * 4, count);
+            }
+        }
+    });
+}
+
+auto Compositor::CompositeScalar(const uint8_t *frame, const uint8_t *background,
+                                 const uint8_t *mask, int32_t maskWidth, int32_t maskHeight,
+                                 uint8_t *output, int32_t width, int32_t height) -> void {
+    const auto scaleX = static_cast<float>(maskWidth) / static_cast<float>(width);
+    const auto scaleY = static_cast<float>(maskHeight) / static_cast<float>(height);
+
+    for (int32_t y = 0; y < height; y++) {
+        for (int32_t x = 0; x < width; x++) {
+            const auto mx = std::min(std::max((x + 0.5f) * scaleX - 0.5f, 0.0f),
+                                     static_cast<float>(maskWidth - 1));
+            const auto my = std::min(std::max((y + 0.5f) * scaleY - 0.5f, 0.0f),
+                                     static_cast<float>(maskHeight - 1));
+            const auto x0 = static_cast<int32_t>(mx);
+            const auto y0 = static_cast<int32_t>(my);
+            const auto x1 = std::min(x0 + 1, maskWidth - 1);
+            const auto y1 = std::min(y0 + 1, maskHeight - 1);
+            const auto wx = mx - static_cast<float>(x0);
+            const auto wy = my - static_cast<float>(y0);
+
+            const auto upper = mask[y0 * maskWidth + x0] * (1.0f - wx) +
+                               mask[y0 * maskWidth + x1] * wx;
+            const auto lower = mask[y1 * maskWidth + x0] * (1.0f - wx) +
+                               mask[y1 * maskWidth + x1] * wx;
+            const auto alpha = (upper * (1.0f - wy) + lower * wy) / 255.0f;
+
+            const auto offset = (static_cast<size_t>(y) * width + x) * 4;
+            for (int32_t c = 0; c < 4; c++) {
+                output[offset + c] = static_cast<uint8_t>(
+                        frame[offset + c] * alpha + background[offset + c] * (1.0f - alpha) +
+                        0.5f);
+            }
+        }
+    }
+}
+
+auto Compositor::Prepare(int32_t width, int32_t maskWidth) -> void {
+    if (width == m_width && maskWidth == m_maskWidth) {
+        return;
+    }
+
+    m_width = width;
+    m_maskWidth = maskWidth;
+    m_columns.resize(width);
+    m_weightsX.resize(width);
+
+    const auto scaleX = static_cast<float>(maskWidth) / static_cast<float>(width);
+    for (int32_t x = 0; x < width; x++) {
+        const auto mx = std::min(std::max((x + 0.5f) * scaleX - 0.5f, 0.0f),
+                                 static_cast<float>(maskWidth - 1));
+        m_columns[x] = static_cast<int32_t>(mx);
+        m_weightsX[x] = static_cast<int32_t>((mx - static_cast<float>(m_columns[x])) * 256.0f +
+                                             0.5f);
+    }
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <vector>
+
+// Blends an RGBA camera frame over an RGBA background through an 8-bit person mask on the CPU,
+// the same result as the mix shader without mask refinement, for headless pipelines and for
+// keeping the blend off a busy GPU. The mask covers the whole frame at a lower resolution, it is
+// upsampled bilinearly inside the blend loop a row at a time, so the full-resolution mask never
+// exists in memory. The blend runs in 16-bit fixed point with NEON, SSE2 or AVX2, rows are split
+// across a thread pool.
+class Compositor {
+public:
+    // threadCount includes the calling thread.
+    explicit Compositor(int32_t threadCount = 1);
+
+    auto SetThreadCount(int32_t threadCount) -> void;
+
+    // frame, background and output are width x height RGBA, output may be frame.
+    auto Composite(const uint8_t *frame, const uint8_t *background, const uint8_t *mask,
+                   int32_t maskWidth, int32_t maskHeight, uint8_t *output, int32_t width,
+                   int32_t height) -> void;
+
+    // Naive reference: single thread, float bilinear sampling and blending per pixel.
+    static auto CompositeScalar(const uint8_t *frame, const uint8_t *background,
+                                const uint8_t *mask, int32_t maskWidth, int32_t maskHeight,
+                                uint8_t *output, int32_t width, int32_t height) -> void;
+
+private:
+    auto Prepare(int32_t width, int32_t maskWidth) -> void;
+
+    ThreadPool m_pool;
+
+    int32_t m_width;
+    int32_t m_maskWidth;
+
+    // Per output column: left mask neighbour and the weight of the right one in 1/256
+    std::vector<int32_t> m_columns;
+    std::vector<int32_t> m_weightsX;
+};
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ImageUtils.h"
+
+auto ResizeImageToFit(int32_t originalWidth, int32_t originalHeight,
+                      int32_t modelWidth, int32_t modelHeight) -> std::tuple<int32_t, int32_t> {
+    auto aspectRatio = static_cast<float>(originalWidth) / static_cast<float>(originalHeight);
+    int imageWidth, imageHeight;
+
+    // Check if the image is wider (landscape) or taller (portrait)
+    if (aspectRatio > 1.0f) {
+        imageWidth = modelWidth;
+        imageHeight = static_cast<int32_t>(static_cast<float>(modelWidth) / aspectRatio);
+    } else {
+        imageHeight = modelHeight;
+        imageWidth = static_cast<int32_t>(static_cast<float>(modelHeight) * aspectRatio);
+    }
+
+    if (imageWidth > modelWidth) {
+        imageWidth = modelWidth;
+        imageHeight = static_cast<int32_t>(static_cast<float>(modelWidth) / aspectRatio);
+    }
+
+    if (imageHeight > modelHeight) {
+        imageHeight = modelHeight;
+        imageWidth = static_cast<int32_t>(static_cast<float>(modelHeight) * aspectRatio);
+    }
+
+    return std::make_tuple(imageWidth, imageHeight);
+}
@@ -0,0 +1,24 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <tuple>
+
+// Largest size with the aspect ratio of the original image that fits into the model input.
+auto ResizeImageToFit(int32_t originalWidth, int32_t originalHeight,
+                      int32_t modelWidth, int32_t modelHeight) -> std::tuple<int32_t, int32_t>;
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// How Segmenter runs the model.
+struct InferenceOptions {
+    // Interpreter and XNNPACK threads, -1 lets TensorFlow Lite decide. Two keeps the big cores
+    // free for the camera and the render thread on most phones.
+    int32_t threadCount = 2;
+    bool useXnnpack = true;
+    // Lets XNNPACK compute in half precision on CPUs with FP16 arithmetic
+    bool allowFp16 = false;
+    // Makes XNNPACK compute in half precision even without FP16 arithmetic, where delegation
+    // may fail and fall back to the builtin kernels. For experiments only.
+    bool forceFp16 = false;
+    // Runs on the builtin TensorFlow Lite kernels when the XNNPACK delegate cannot be applied,
+    // otherwise initialization fails
+    bool fallbackToBuiltinKernels = true;
+    // Runs one invoke on a synthetic input during initialization, so weight packing and cold
+    // caches do not stall the first camera frames
+    bool warmUp = true;
+    // Directory for the XNNPACK packed weights cache, e.g. the app cache directory. Later
+    // launches load the packed weights from there instead of repacking them. Empty disables it.
+    std::string cacheDirectory;
+};
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "InferenceScheduler.h"
+
+#include <cstdlib>
+
+// A few levels of sensor noise survive the downscale, stay above them
+static constexpr float kDefaultMotionThreshold = 0.015f;
+static constexpr int32_t kDefaultMaxSkippedFrames = 5;
+
+// Every second pixel of every second row, a quarter of the readback is plenty for the metric
+static constexpr int32_t kSampleStep = 2;
+
+InferenceScheduler::InferenceScheduler()
+        : m_motionThreshold(kDefaultMotionThreshold),
+          m_maxSkippedFrames(kDefaultMaxSkippedFrames),
+          m_width(0),
+          m_height(0),
+          m_stride(0),
+          m_channels(3),
+          m_hasReference(false),
+          m_skippedInRow(0),
+          m_motion(0.0f),
+          m_inferredFrames(0),
+          m_skippedFrames(0) {
+}
+
+auto InferenceScheduler::SetThresholds(float motionThreshold, int32_t maxSkippedFrames) -> void {
+    m_motionThreshold = motionThreshold;
+    m_maxSkippedFrames = maxSkippedFrames;
+}
+
+auto InferenceScheduler::Reset(int32_t width, int32_t height, int32_t stride,
+                               int32_t channels) -> void {
+    m_width = width;
+    m_height = height;
+    m_stride = stride;
+    m_channels = channels;
+
+    auto samplesX = (width + kSampleStep - 1) / kSampleStep;
+    auto samplesY = (height + kSampleStep - 1) / kSampleStep;
+    m_reference.resize(static_cast<size_t>(samplesX) * samplesY * 3);
+
+    m_hasReference = false;
+    m_skippedInRow = 0;
+}
+
+auto InferenceScheduler::ShouldInfer(const uint8_t *image) -> bool {
+    if (!m_hasReference || m_skippedInRow >= m_maxSkippedFrames) {
+        m_motion = Sample(image, true);
+        m_hasReference = true;
+    } else {
+        m_motion = Sample(image, false);
+        if (m_motion < m_motionThreshold) {
+            m_skippedInRow++;
+            m_skippedFrames++;
+            return false;
+        }
+        Sample(image, true);
+    }
+
+    m_skippedInRow = 0;
+    m_inferredFrames++;
+    return true;
+}
+
+auto InferenceScheduler::Motion() const -> float {
+    return m_motion;
+}
+
+auto InferenceScheduler::InferredFrames() const -> uint64_t {
+    return m_inferredFrames;
+}
+
+auto InferenceScheduler::SkippedFrames() const -> uint64_t {
+    return m_skippedFrames;
+}
+
+auto InferenceScheduler::Sample(const uint8_t *image, bool store) -> float {
+    auto reference = m_reference.data();
+    uint64_t sum = 0;
+
+    for (int32_t y = 0; y < m_height; y += kSampleStep) {
+        auto row = image + static_cast<size_t>(y) * m_stride * m_channels;
+        for (int32_t x = 0; x < m_width; x += kSampleStep) {
+            for (int32_t c = 0; c < 3; c++) {
+                auto value = row[x * m_channels + c];
+                sum += std::abs(static_cast<int32_t>(value) - reference[c]);
+                if (store) {
+                    reference[c] = value;
+                }
+            }
+            reference += 3;
+        }
+    }
+
+    auto count = static_cast<size_t>(reference - m_reference.data());
+    return count > 0 ? static_cast<float>(sum) / (static_cast<float>(count) * 255.0f) : 0.0f;
+}
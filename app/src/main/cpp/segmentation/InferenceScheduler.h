@@ -0,0 +1,65 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Decides per frame whether segmentation has to run, so a static scene does not keep the
+// interpreter busy. The motion metric is the mean absolute channel difference, in [0, 1], between
+// the frame and the one the last inference ran on, sampled on a sparse grid of the downscaled
+// readback. Inference runs when it passes the threshold, or after maxSkippedFrames frames at the
+// latest so slow drift and lighting changes still reach the mask.
+class InferenceScheduler {
+public:
+    InferenceScheduler();
+
+    // maxSkippedFrames 0 runs inference on every frame.
+    auto SetThresholds(float motionThreshold, int32_t maxSkippedFrames) -> void;
+
+    // Sizes the reference frame for images of width x height pixels with rows stride pixels
+    // apart, so the image can be part of a larger one. Pixels are channels bytes apart, RGB or
+    // RGBA, only the first 3 are compared. The next frame always runs inference.
+    auto Reset(int32_t width, int32_t height, int32_t stride, int32_t channels) -> void;
+
+    auto ShouldInfer(const uint8_t *image) -> bool;
+
+    // Motion metric of the last ShouldInfer() call.
+    auto Motion() const -> float;
+
+    auto InferredFrames() const -> uint64_t;
+
+    auto SkippedFrames() const -> uint64_t;
+
+private:
+    auto Sample(const uint8_t *image, bool store) -> float;
+
+    float m_motionThreshold;
+    int32_t m_maxSkippedFrames;
+
+    int32_t m_width;
+    int32_t m_height;
+    int32_t m_stride;
+    int32_t m_channels;
+    std::vector<uint8_t> m_reference;
+    bool m_hasReference;
+    int32_t m_skippedInRow;
+    float m_motion;
+
+    uint64_t m_inferredFrames;
+    uint64_t m_skippedFrames;
+};
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "InferenceWorker.h"
+
+InferenceWorker::InferenceWorker()
+        : m_running(false),
+          m_droppedFrames(0) {
+}
+
+InferenceWorker::~InferenceWorker() {
+    Stop();
+}
+
+auto InferenceWorker::Start(Job job, size_t imageSize, size_t maskSize) -> void {
+    Stop();
+
+    // Both queues are idle here, so the slots can be (re)allocated up front
+    m_frames.Clear();
+    for (auto &frame: m_frames.Slots()) {
+        frame.pixels.resize(imageSize);
+        frame.index = 0;
+        frame.region = RegionTracker::kFullFrame;
+    }
+
+    m_masks.Clear();
+    for (auto &mask: m_masks.Slots()) {
+        mask.pixels.resize(maskSize);
+        mask.frameIndex = 0;
+        mask.region = RegionTracker::kFullFrame;
+    }
+
+    m_job = std::move(job);
+    m_droppedFrames = 0;
+    m_running = true;
+    m_thread = std::thread(&InferenceWorker::Run, this);
+}
+
+auto InferenceWorker::Stop() -> void {
+    if (!m_thread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_condition.notify_one();
+    m_idleCondition.notify_all();
+    m_thread.join();
+}
+
+auto InferenceWorker::AcquireFrame() -> InferenceFrame * {
+    auto frame = m_frames.Back();
+    if (frame == nullptr) {
+        m_droppedFrames.fetch_add(1, std::memory_order_relaxed);
+    }
+    return frame;
+}
+
+auto InferenceWorker::SubmitFrame(uint64_t index) -> void {
+    m_frames.Back()->index = index;
+
+    {
+        // The lock only orders the push against the worker going to sleep, it is never held
+        // while the interpreter runs
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_frames.Push();
+    }
+    m_condition.notify_one();
+}
+
+auto InferenceWorker::AcquireMask() -> const InferenceMask * {
+    while (m_masks.Size() > 1) {
+        m_masks.Pop();
+    }
+    return m_masks.Front();
+}
+
+auto InferenceWorker::ReleaseMask() -> void {
+    m_masks.Pop();
+}
+
+auto InferenceWorker::WaitIdle() -> void {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idleCondition.wait(lock, [this] { return !m_running || m_frames.Size() == 0; });
+}
+
+auto InferenceWorker::QueueDepth() const -> size_t {
+    return m_frames.Size();
+}
+
+auto InferenceWorker::DroppedFrames() const -> uint64_t {
+    return m_droppedFrames.load(std::memory_order_relaxed);
+}
+
+auto InferenceWorker::Run() -> void {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] { return !m_running || m_frames.Size() > 0; });
+            if (!m_running) {
+                break;
+            }
+        }
+
+        // Latest wins: skip every queued frame but the most recent one
+        while (m_frames.Size() > 1) {
+            m_frames.Pop();
+            m_droppedFrames.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        auto frame = m_frames.Front();
+        auto mask = m_masks.Back();
+        if (mask != nullptr) {
+            m_job(frame->pixels, frame->region, mask->pixels);
+            mask->frameIndex = frame->index;
+            mask->region = frame->region;
+            m_masks.Push();
+        } else {
+            m_droppedFrames.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_frames.Pop();
+
+        {
+            // Same as in SubmitFrame, orders the pop against WaitIdle() going to sleep
+            std::lock_guard<std::mutex> lock(m_mutex);
+        }
+        m_idleCondition.notify_all();
+    }
+}
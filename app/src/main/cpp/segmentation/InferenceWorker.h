@@ -0,0 +1,93 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "RegionTracker.h"
+#include "SpscQueue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// region is the part of the camera frame the pixels were taken from, the mask covers the same one
+struct InferenceFrame {
+    std::vector<uint8_t> pixels;
+    uint64_t index;
+    MaskRegion region;
+};
+
+struct InferenceMask {
+    std::vector<uint8_t> pixels;
+    uint64_t frameIndex;
+    MaskRegion region;
+};
+
+// Runs segmentation on a dedicated thread so the render loop never waits for the interpreter.
+// Frames flow in and masks flow out through lock-free single-producer/single-consumer queues.
+// When the worker falls behind, it skips to the most recent queued frame and the older ones are
+// counted as dropped.
+class InferenceWorker {
+public:
+    using Job = std::function<void(const std::vector<uint8_t> &image, const MaskRegion &region,
+                                   std::vector<uint8_t> &mask)>;
+
+    InferenceWorker();
+
+    ~InferenceWorker();
+
+    auto Start(Job job, size_t imageSize, size_t maskSize) -> void;
+
+    auto Stop() -> void;
+
+    // Producer side (render thread). Returns nullptr and counts a dropped frame when the queue is
+    // full, otherwise the returned frame has to be filled and handed over with SubmitFrame().
+    auto AcquireFrame() -> InferenceFrame *;
+
+    auto SubmitFrame(uint64_t index) -> void;
+
+    // Consumer side (render thread). Returns the most recent finished mask or nullptr when no new
+    // mask is available, a returned mask has to be given back with ReleaseMask().
+    auto AcquireMask() -> const InferenceMask *;
+
+    auto ReleaseMask() -> void;
+
+    // Blocks until every submitted frame has been processed, its mask is then ready to acquire.
+    auto WaitIdle() -> void;
+
+    auto QueueDepth() const -> size_t;
+
+    auto DroppedFrames() const -> uint64_t;
+
+private:
+    auto Run() -> void;
+
+    static constexpr size_t kQueueCapacity = 3;
+
+    SpscQueue<InferenceFrame, kQueueCapacity> m_frames;
+    SpscQueue<InferenceMask, kQueueCapacity> m_masks;
+    Job m_job;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::condition_variable m_idleCondition;
+    std::atomic<bool> m_running;
+    std::atomic<uint64_t> m_droppedFrames;
+};
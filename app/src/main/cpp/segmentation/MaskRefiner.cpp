@@ -0,0 +1,346 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MaskRefiner.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+static constexpr float kDefaultRangeSigma = 0.1f;
+
+// Pointers into the gathered neighbour arrays for one output row
+struct NeighbourRow {
+    const float *luma;
+    const float *weightsX;
+    const float *mask[4];
+    const float *guide[4];
+};
+
+using BlendRowFunction = void (*)(const NeighbourRow &row, float weightY, float rangeScale,
+                                  uint8_t *output, int32_t begin, int32_t end);
+
+static auto Luma(const uint8_t *pixel) -> float {
+    return (0.299f * pixel[0] + 0.587f * pixel[1] + 0.114f * pixel[2]) * (1.0f / 255.0f);
+}
+
+// Position of the center of texel i of a grid scaled by scale in the pixels of a size long axis,
+// clamped to the pixel centers like texture sampling clamps to the edge
+static auto SamplePosition(int32_t i, float scale, int32_t size) -> float {
+    return std::min(std::max((i + 0.5f) * scale - 0.5f, 0.0f), static_cast<float>(size - 1));
+}
+
+static auto BlendRowScalar(const NeighbourRow &row, float weightY, float rangeScale,
+                           uint8_t *output, int32_t begin, int32_t end) -> void {
+    for (int32_t x = begin; x < end; x++) {
+        auto wx = row.weightsX[x];
+        float bilinear[4] = {(1.0f - wx) * (1.0f - weightY), wx * (1.0f - weightY),
+                             (1.0f - wx) * weightY, wx * weightY};
+
+        auto numerator = 0.0f;
+        auto denominator = 0.0f;
+        for (int k = 0; k < 4; k++) {
+            auto d = row.luma[x] - row.guide[k][x];
+            auto w = bilinear[k] / (1.0f + d * d * rangeScale);
+            numerator += w * row.mask[k][x];
+            denominator += w;
+        }
+
+        output[x] = static_cast<uint8_t>(numerator / denominator * 255.0f + 0.5f);
+    }
+}
+
+#if defined(__ARM_NEON)
+
+static auto Reciprocal(float32x4_t value) -> float32x4_t {
+    // Estimate refined by two Newton-Raphson steps, ARMv7 has no vector division
+    auto estimate = vrecpeq_f32(value);
+    estimate = vmulq_f32(vrecpsq_f32(value, estimate), estimate);
+    return vmulq_f32(vrecpsq_f32(value, estimate), estimate);
+}
+
+static auto BlendRowNeon(const NeighbourRow &row, float weightY, float rangeScale,
+                         uint8_t *output, int32_t begin, int32_t end) -> void {
+    const auto one = vdupq_n_f32(1.0f);
+    const auto wy1 = vdupq_n_f32(weightY);
+    const auto wy0 = vdupq_n_f32(1.0f - weightY);
+    const auto range = vdupq_n_f32(rangeScale);
+    const auto scale = vdupq_n_f32(255.0f);
+    const auto half = vdupq_n_f32(0.5f);
+
+    auto x = begin;
+    for (; x + 4 <= end; x += 4) {
+        auto luma = vld1q_f32(row.luma + x);
+        auto wx1 = vld1q_f32(row.weightsX + x);
+        auto wx0 = vsubq_f32(one, wx1);
+        float32x4_t bilinear[4] = {vmulq_f32(wx0, wy0), vmulq_f32(wx1, wy0),
+                                   vmulq_f32(wx0, wy1), vmulq_f32(wx1, wy1)};
+
+        auto numerator = vdupq_n_f32(0.0f);
+        auto denominator = vdupq_n_f32(0.0f);
+        for (int k = 0; k < 4; k++) {
+            auto d = vsubq_f32(luma, vld1q_f32(row.guide[k] + x));
+            auto falloff = vmlaq_f32(one, vmulq_f32(d, d), range);
+            auto w = vmulq_f32(bilinear[k], Reciprocal(falloff));
+            numerator = vmlaq_f32(numerator, w, vld1q_f32(row.mask[k] + x));
+            denominator = vaddq_f32(denominator, w);
+        }
+
+        auto value = vmulq_f32(numerator, Reciprocal(denominator));
+        auto q = vcvtq_u32_f32(vmlaq_f32(half, value, scale));
+        auto bytes = vmovn_u16(vcombine_u16(vmovn_u32(q), vmovn_u32(q)));
+        vst1_lane_u32(reinterpret_cast<uint32_t *>(output + x), vreinterpret_u32_u8(bytes), 0);
+    }
+
+    BlendRowScalar(row, weightY, rangeScale, output, x, end);
+}
+
+static auto SelectBlendRow() -> BlendRowFunction {
+    return BlendRowNeon;
+}
+
+#elif defined(__x86_64__) || defined(__i386__)
+
+static auto BlendRowSse2(const NeighbourRow &row, float weightY, float rangeScale,
+                         uint8_t *output, int32_t begin, int32_t end) -> void {
+    const auto one = _mm_set1_ps(1.0f);
+    const auto wy1 = _mm_set1_ps(weightY);
+    const auto wy0 = _mm_set1_ps(1.0f - weightY);
+    const auto range = _mm_set1_ps(rangeScale);
+    const auto scale = _mm_set1_ps(255.0f);
+    const auto half = _mm_set1_ps(0.5f);
+
+    auto x = begin;
+    for (; x + 4 <= end; x += 4) {
+        auto luma = _mm_loadu_ps(row.luma + x);
+        auto wx1 = _mm_loadu_ps(row.weightsX + x);
+        auto wx0 = _mm_sub_ps(one, wx1);
+        __m128 bilinear[4] = {_mm_mul_ps(wx0, wy0), _mm_mul_ps(wx1, wy0),
+                              _mm_mul_ps(wx0, wy1), _mm_mul_ps(wx1, wy1)};
+
+        auto numerator = _mm_setzero_ps();
+        auto denominator = _mm_setzero_ps();
+        for (int k = 0; k < 4; k++) {
+            auto d = _mm_sub_ps(luma, _mm_loadu_ps(row.guide[k] + x));
+            auto falloff = _mm_add_ps(one, _mm_mul_ps(_mm_mul_ps(d, d), range));
+            auto w = _mm_div_ps(bilinear[k], falloff);
+            numerator = _mm_add_ps(numerator, _mm_mul_ps(w, _mm_loadu_ps(row.mask[k] + x)));
+            denominator = _mm_add_ps(denominator, w);
+        }
+
+        auto value = _mm_div_ps(numerator, denominator);
+        auto q = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, scale), half));
+        auto words = _mm_packs_epi32(q, q);
+        auto bytes = _mm_packus_epi16(words, words);
+        auto packed = _mm_cvtsi128_si32(bytes);
+        std::copy_n(reinterpret_cast<const uint8_t *>(&packed), 4, output + x);
+    }
+
+    BlendRowScalar(row, weightY, rangeScale, output, x, end);
+}
+
+__attribute__((target("avx2,fma")))
+static auto BlendRowAvx2(const NeighbourRow &row, float weightY, float rangeScale,
+                         uint8_t *output, int32_t begin, int32_t end) -> void {
+    const auto one = _mm256_set1_ps(1.0f);
+    const auto wy1 = _mm256_set1_ps(weightY);
+    const auto wy0 = _mm256_set1_ps(1.0f - weightY);
+    const auto range = _mm256_set1_ps(rangeScale);
+    const auto scale = _mm256_set1_ps(255.0f);
+    const auto half = _mm256_set1_ps(0.5f);
+
+    auto x = begin;
+    for (; x + 8 <= end; x += 8) {
+        auto luma = _mm256_loadu_ps(row.luma + x);
+        auto wx1 = _mm256_loadu_ps(row.weightsX + x);
+        auto wx0 = _mm256_sub_ps(one, wx1);
+        __m256 bilinear[4] = {_mm256_mul_ps(wx0, wy0), _mm256_mul_ps(wx1, wy0),
+                              _mm256_mul_ps(wx0, wy1), _mm256_mul_ps(wx1, wy1)};
+
+        auto numerator = _mm256_setzero_ps();
+        auto denominator = _mm256_setzero_ps();
+        for (int k = 0; k < 4; k++) {
+            auto d = _mm256_sub_ps(luma, _mm256_loadu_ps(row.guide[k] + x));
+            auto falloff = _mm256_fmadd_ps(_mm256_mul_ps(d, d), range, one);
+            auto w = _mm256_div_ps(bilinear[k], falloff);
+            numerator = _mm256_fmadd_ps(w, _mm256_loadu_ps(row.mask[k] + x), numerator);
+            denominator = _mm256_add_ps(denominator, w);
+        }
+
+        auto value = _mm256_div_ps(numerator, denominator);
+        auto q = _mm256_cvttps_epi32(_mm256_fmadd_ps(value, scale, half));
+        auto words = _mm_packs_epi32(_mm256_castsi256_si128(q), _mm256_extracti128_si256(q, 1));
+        auto bytes = _mm_packus_epi16(words, words);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(output + x), bytes);
+    }
+
+    BlendRowScalar(row, weightY, rangeScale, output, x, end);
+}
+
+static auto SelectBlendRow() -> BlendRowFunction {
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return BlendRowAvx2;
+    }
+    return BlendRowSse2;
+}
+
+#else
+
+static auto SelectBlendRow() -> BlendRowFunction {
+    return BlendRowScalar;
+}
+
+#endif
+
+MaskRefiner::MaskRefiner()
+        : m_rangeScale(1.0f / (kDefaultRangeSigma * kDefaultRangeSigma)),
+          m_width(0),
+          m_maskWidth(0),
+          m_maskHeight(0) {
+}
+
+auto MaskRefiner::SetRangeSigma(float sigma) -> void {
+    m_rangeScale = 1.0f / (sigma * sigma);
+}
+
+auto MaskRefiner::Refine(const uint8_t *guide, int32_t width, int32_t height,
+                         const uint8_t *mask, int32_t maskWidth, int32_t maskHeight,
+                         uint8_t *output) -> void {
+    Refine(guide, width, height, mask, maskWidth, maskHeight, output, true);
+}
+
+auto MaskRefiner::RefineScalar(const uint8_t *guide, int32_t width, int32_t height,
+                               const uint8_t *mask, int32_t maskWidth, int32_t maskHeight,
+                               uint8_t *output) -> void {
+    Refine(guide, width, height, mask, maskWidth, maskHeight, output, false);
+}
+
+auto MaskRefiner::Refine(const uint8_t *guide, int32_t width, int32_t height,
+                         const uint8_t *mask, int32_t maskWidth, int32_t maskHeight,
+                         uint8_t *output, bool vectorized) -> void {
+    static const auto blendRowSimd = SelectBlendRow();
+    const auto blendRow = vectorized ? blendRowSimd : BlendRowScalar;
+
+    Prepare(width, maskWidth, maskHeight);
+    SampleGuide(guide, width, height);
+
+    const auto stride = static_cast<size_t>(width);
+    NeighbourRow row = {
+            m_luma.data(), m_weightsX.data(),
+            {m_neighbours.data(), m_neighbours.data() + stride,
+             m_neighbours.data() + 2 * stride, m_neighbours.data() + 3 * stride},
+            {m_neighbours.data() + 4 * stride, m_neighbours.data() + 5 * stride,
+             m_neighbours.data() + 6 * stride, m_neighbours.data() + 7 * stride}
+    };
+
+    const auto scaleY = static_cast<float>(maskHeight) / static_cast<float>(height);
+    auto gatheredRow = -1;
+
+    for (int32_t y = 0; y < height; y++) {
+        auto my = SamplePosition(y, scaleY, maskHeight);
+        auto y0 = static_cast<int32_t>(my);
+        auto y1 = std::min(y0 + 1, maskHeight - 1);
+
+        // Output rows are sorted, so the neighbours only change once per mask row
+        if (y0 != gatheredRow) {
+            GatherRows(mask, maskWidth, y0, y1);
+            gatheredRow = y0;
+        }
+
+        auto guideRow = guide + y * stride * 4;
+        for (int32_t x = 0; x < width; x++) {
+            m_luma[x] = Luma(guideRow + x * 4);
+        }
+
+        blendRow(row, my - static_cast<float>(y0), m_rangeScale, output + y * stride, 0, width);
+    }
+}
+
+auto MaskRefiner::Prepare(int32_t width, int32_t maskWidth, int32_t maskHeight) -> void {
+    if (width == m_width && maskWidth == m_maskWidth && maskHeight == m_maskHeight) {
+        return;
+    }
+
+    m_width = width;
+    m_maskWidth = maskWidth;
+    m_maskHeight = maskHeight;
+
+    m_columns.resize(width);
+    m_weightsX.resize(width);
+    m_lowLuma.resize(maskWidth * maskHeight);
+    m_luma.resize(width);
+    m_neighbours.resize(8 * static_cast<size_t>(width));
+
+    const auto scaleX = static_cast<float>(maskWidth) / static_cast<float>(width);
+    for (int32_t x = 0; x < width; x++) {
+        auto mx = SamplePosition(x, scaleX, maskWidth);
+        m_columns[x] = static_cast<int32_t>(mx);
+        m_weightsX[x] = mx - static_cast<float>(m_columns[x]);
+    }
+}
+
+auto MaskRefiner::SampleGuide(const uint8_t *guide, int32_t width, int32_t height) -> void {
+    const auto scaleX = static_cast<float>(width) / static_cast<float>(m_maskWidth);
+    const auto scaleY = static_cast<float>(height) / static_cast<float>(m_maskHeight);
+    const auto stride = static_cast<size_t>(width) * 4;
+
+    for (int32_t row = 0; row < m_maskHeight; row++) {
+        auto gy = SamplePosition(row, scaleY, height);
+        auto y0 = static_cast<int32_t>(gy);
+        auto y1 = std::min(y0 + 1, height - 1);
+        auto fy = gy - static_cast<float>(y0);
+        auto top = guide + y0 * stride;
+        auto bottom = guide + y1 * stride;
+
+        for (int32_t column = 0; column < m_maskWidth; column++) {
+            auto gx = SamplePosition(column, scaleX, width);
+            auto x0 = static_cast<int32_t>(gx);
+            auto x1 = std::min(x0 + 1, width - 1);
+            auto fx = gx - static_cast<float>(x0);
+
+            // Luminance is linear in the color, so this equals the luminance of the bilinear
+            // color sample the shader takes
+            auto upper = Luma(top + x0 * 4) + fx * (Luma(top + x1 * 4) - Luma(top + x0 * 4));
+            auto lower = Luma(bottom + x0 * 4) +
+                         fx * (Luma(bottom + x1 * 4) - Luma(bottom + x0 * 4));
+            m_lowLuma[row * m_maskWidth + column] = upper + fy * (lower - upper);
+        }
+    }
+}
+
+auto MaskRefiner::GatherRows(const uint8_t *mask, int32_t maskWidth, int32_t y0,
+                             int32_t y1) -> void {
+    const auto stride = static_cast<size_t>(m_width);
+    const int32_t rows[4] = {y0, y0, y1, y1};
+
+    for (int k = 0; k < 4; k++) {
+        auto maskValues = m_neighbours.data() + k * stride;
+        auto guideValues = m_neighbours.data() + (4 + k) * stride;
+        auto right = k % 2;
+
+        for (int32_t x = 0; x < m_width; x++) {
+            auto column = std::min(m_columns[x] + right, maskWidth - 1);
+            auto index = rows[k] * maskWidth + column;
+            maskValues[x] = mask[index] * (1.0f / 255.0f);
+            guideValues[x] = m_lowLuma[index];
+        }
+    }
+}
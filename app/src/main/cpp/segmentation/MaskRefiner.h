@@ -0,0 +1,73 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Edge-aware upsampling of a low-resolution mask to the resolution of the camera frame (joint
+// bilateral upsampling). Every output pixel blends its four bilinear mask neighbours, weighting
+// each one down by how much the guide luminance at the neighbour differs from the guide luminance
+// at the pixel, so mask edges snap to image edges instead of being stretched into halos. Like the
+// refinement branch of the mix shader, the guide at a neighbour is the frame bilinearly sampled at
+// the center of its mask texel and the range weight is 1 / (1 + d^2 / sigma^2). Within half a mask
+// texel of the border the shader also weighs in clamped texels outside the mask, this does not.
+class MaskRefiner {
+public:
+    MaskRefiner();
+
+    auto SetRangeSigma(float sigma) -> void;
+
+    // guide is the RGBA frame of width x height the mask covers. Writes a width x height mask.
+    auto Refine(const uint8_t *guide, int32_t width, int32_t height,
+                const uint8_t *mask, int32_t maskWidth, int32_t maskHeight,
+                uint8_t *output) -> void;
+
+    // Same as Refine, without SIMD.
+    auto RefineScalar(const uint8_t *guide, int32_t width, int32_t height,
+                      const uint8_t *mask, int32_t maskWidth, int32_t maskHeight,
+                      uint8_t *output) -> void;
+
+private:
+    auto Refine(const uint8_t *guide, int32_t width, int32_t height,
+                const uint8_t *mask, int32_t maskWidth, int32_t maskHeight,
+                uint8_t *output, bool vectorized) -> void;
+
+    auto Prepare(int32_t width, int32_t maskWidth, int32_t maskHeight) -> void;
+
+    auto SampleGuide(const uint8_t *guide, int32_t width, int32_t height) -> void;
+
+    auto GatherRows(const uint8_t *mask, int32_t maskWidth, int32_t y0, int32_t y1) -> void;
+
+    float m_rangeScale;
+
+    int32_t m_width;
+    int32_t m_maskWidth;
+    int32_t m_maskHeight;
+
+    // Per output column: left mask neighbour and the weight of the right one
+    std::vector<int32_t> m_columns;
+    std::vector<float> m_weightsX;
+
+    // Guide luminance at the mask texel centers and of the current output row
+    std::vector<float> m_lowLuma;
+    std::vector<float> m_luma;
+
+    // Mask values and guide luminance of the four neighbours of every output column, gathered
+    // once per pair of mask rows: top-left, top-right, bottom-left, bottom-right
+    std::vector<float> m_neighbours;
+};
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ModelFile.h"
+
+#include "Log.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+ModelFile::ModelFile()
+        : m_pMapping(nullptr),
+          m_mappingSize(0),
+          m_pData(nullptr),
+          m_size(0),
+          m_contentHash(0) {
+}
+
+ModelFile::~ModelFile() {
+    Unmap();
+}
+
+auto ModelFile::Map(int fd, off_t offset, size_t length) -> bool {
+    Unmap();
+    m_buffer.clear();
+
+    // mmap wants a page aligned offset, map from the start of the page and skip the head
+    const auto pageSize = static_cast<off_t>(sysconf(_SC_PAGESIZE));
+    const auto alignedOffset = offset / pageSize * pageSize;
+    const auto head = static_cast<size_t>(offset - alignedOffset);
+
+    auto mapping = mmap(nullptr, length + head, PROT_READ, MAP_PRIVATE, fd, alignedOffset);
+    if (mapping == MAP_FAILED) {
+        LOGE("Could not map model: %s\n", strerror(errno));
+        return false;
+    }
+
+    m_pMapping = mapping;
+    m_mappingSize = length + head;
+    m_pData = static_cast<const char *>(mapping) + head;
+    m_size = length;
+    m_contentHash = 0;
+    return true;
+}
+
+auto ModelFile::Map(const char *path) -> bool {
+    auto fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOGE("Could not open model %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    struct stat status = {};
+    auto mapped = fstat(fd, &status) == 0 && Map(fd, 0, static_cast<size_t>(status.st_size));
+    close(fd);
+    return mapped;
+}
+
+auto ModelFile::Copy(const void *data, size_t size) -> void {
+    Unmap();
+
+    auto bytes = static_cast<const char *>(data);
+    m_buffer.assign(bytes, bytes + size);
+    m_pData = m_buffer.data();
+    m_size = size;
+    m_contentHash = 0;
+}
+
+auto ModelFile::Data() const -> const char * {
+    return m_pData;
+}
+
+auto ModelFile::Size() const -> size_t {
+    return m_size;
+}
+
+auto ModelFile::IsMapped() const -> bool {
+    return m_pMapping != nullptr;
+}
+
+auto ModelFile::ContentHash() const -> uint64_t {
+    if (m_contentHash == 0) {
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < m_size; i++) {
+            hash = (hash ^ static_cast<uint8_t>(m_pData[i])) * 1099511628211ull;
+        }
+        m_contentHash = hash;
+    }
+    return m_contentHash;
+}
+
+auto ModelFile::Unmap() -> void {
+    if (m_pMapping != nullptr) {
+        munmap(m_pMapping, m_mappingSize);
+        m_pMapping = nullptr;
+        m_mappingSize = 0;
+    }
+    m_pData = nullptr;
+    m_size = 0;
+}
+
+auto ResidentMemory() -> size_t {
+    // The second field of statm is the resident page count
+    auto file = fopen("/proc/self/statm", "r");
+    if (file == nullptr) {
+        return 0;
+    }
+
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    auto fields = fscanf(file, "%lu %lu", &size, &resident);
+    fclose(file);
+
+    return fields == 2 ? static_cast<size_t>(resident) * static_cast<size_t>(sysconf(_SC_PAGESIZE))
+                       : 0;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Read-only model bytes for TensorFlow Lite, preferably mapped straight from the file so the
+// flatbuffer never gets a heap copy and its pages can be shared and reclaimed by the kernel. Has
+// to outlive the FlatBufferModel and the interpreter built from it.
+class ModelFile {
+public:
+    ModelFile();
+
+    ~ModelFile();
+
+    ModelFile(const ModelFile &) = delete;
+
+    auto operator=(const ModelFile &) -> ModelFile & = delete;
+
+    // Maps length bytes at offset of an open file, e.g. an uncompressed APK asset. The descriptor
+    // can be closed afterwards.
+    auto Map(int fd, off_t offset, size_t length) -> bool;
+
+    auto Map(const char *path) -> bool;
+
+    // Fallback for data that cannot be mapped, e.g. a compressed asset.
+    auto Copy(const void *data, size_t size) -> void;
+
+    auto Data() const -> const char *;
+
+    auto Size() const -> size_t;
+
+    auto IsMapped() const -> bool;
+
+    // 64-bit FNV-1a hash of the model bytes, computed on the first call. Identifies the model
+    // contents, e.g. for caches derived from them.
+    auto ContentHash() const -> uint64_t;
+
+private:
+    auto Unmap() -> void;
+
+    void *m_pMapping;
+    size_t m_mappingSize;
+    const char *m_pData;
+    size_t m_size;
+    std::vector<char> m_buffer;
+    // 0 until ContentHash() computed it for the current bytes
+    mutable uint64_t m_contentHash;
+};
+
+// Opens the model file at path, e.g. from the APK assets on Android or from a directory on
+// desktop. Returns nullptr when it cannot be read.
+using ModelLoader = std::function<std::unique_ptr<ModelFile>(const char *path)>;
+
+// Resident set size of the process in bytes, 0 when unknown. Used to measure model loading.
+auto ResidentMemory() -> size_t;
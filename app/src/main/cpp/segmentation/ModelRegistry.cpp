@@ -0,0 +1,58 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ModelRegistry.h"
+
+#include <cstring>
+#include <iterator>
+
+// The multiclass model labels every pixel as background, hair, body skin, face skin, clothes or
+// other, the person is everything but the background. All of them take [-1, 1] input. Only the
+// square model ships in assets/model, the others are skipped when their files are missing, see
+// CameraVirtualBackgroundProcessor::SelectModel().
+static const ModelDescriptor kModels[] = {
+        {"multiclass", "model/selfie_multiclass_256x256.tflite", 256, 256, 127.5f, 127.5f, 6, 0,
+         true},
+        {"square", "model/selfie_segmenter.tflite", 256, 256, 127.5f, 127.5f, 1, 0, false},
+        {"landscape", "model/selfie_segmenter_landscape.tflite", 256, 144, 127.5f, 127.5f, 1, 0,
+         false},
+};
+
+auto Models() -> const ModelDescriptor * {
+    return kModels;
+}
+
+auto ModelCount() -> size_t {
+    return std::size(kModels);
+}
+
+auto FindModel(const char *name) -> const ModelDescriptor * {
+    for (const auto &model: kModels) {
+        if (strcmp(model.name, name) == 0) {
+            return &model;
+        }
+    }
+    return nullptr;
+}
+
+auto FasterModel(const ModelDescriptor &model) -> const ModelDescriptor * {
+    for (size_t i = 0; i + 1 < std::size(kModels); i++) {
+        if (&kModels[i] == &model) {
+            return &kModels[i + 1];
+        }
+    }
+    return nullptr;
+}
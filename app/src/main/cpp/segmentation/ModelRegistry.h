@@ -0,0 +1,48 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Everything Segmenter needs to know about a segmentation model besides the tensor types, which
+// it reads from the model itself. Tensors are NHWC.
+struct ModelDescriptor {
+    const char *name;
+    // Asset path of the .tflite file
+    const char *path;
+    int32_t width;
+    int32_t height;
+    // Channel values are normalized as (value - mean) / stddev
+    float mean;
+    float stddev;
+    int32_t outputChannels;
+    int32_t personChannel;
+    // The person channel holds the background probability, e.g. class 0 of multiclass models
+    bool invertPerson;
+};
+
+// Known models ordered from the most expensive to the cheapest.
+auto Models() -> const ModelDescriptor *;
+
+auto ModelCount() -> size_t;
+
+// nullptr for unknown names.
+auto FindModel(const char *name) -> const ModelDescriptor *;
+
+// The next cheaper model in Models(), nullptr when model is already the cheapest.
+auto FasterModel(const ModelDescriptor &model) -> const ModelDescriptor *;
@@ -0,0 +1,249 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Postprocess.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// The row kernels compute clamp(value * scale + bias, 0, 255), which covers dequantization
+using QuantizeRowFunction = void (*)(const float *src, uint8_t *dst, size_t count,
+                                     float scale, float bias);
+
+static auto QuantizeValue(float value, float scale, float bias) -> uint8_t {
+    return static_cast<uint8_t>(std::min(std::max(value * scale + bias, 0.0f), 255.0f) + 0.5f);
+}
+
+static auto QuantizeRowScalar(const float *src, uint8_t *dst, size_t count,
+                              float scale, float bias) -> void {
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = QuantizeValue(src[i], scale, bias);
+    }
+}
+
+#if defined(__ARM_NEON)
+
+static auto QuantizeRowNeon(const float *src, uint8_t *dst, size_t count,
+                            float scale, float bias) -> void {
+    const auto zero = vdupq_n_f32(0.0f);
+    const auto max = vdupq_n_f32(255.0f);
+    const auto vScale = vdupq_n_f32(scale);
+    const auto vBias = vdupq_n_f32(bias);
+    const auto half = vdupq_n_f32(0.5f);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint32x4_t q[4];
+        for (int k = 0; k < 4; k++) {
+            auto p = vmlaq_f32(vBias, vld1q_f32(src + i + k * 4), vScale);
+            q[k] = vcvtq_u32_f32(vaddq_f32(vminq_f32(vmaxq_f32(p, zero), max), half));
+        }
+
+        auto low = vcombine_u16(vmovn_u32(q[0]), vmovn_u32(q[1]));
+        auto high = vcombine_u16(vmovn_u32(q[2]), vmovn_u32(q[3]));
+        vst1q_u8(dst + i, vcombine_u8(vmovn_u16(low), vmovn_u16(high)));
+    }
+
+    QuantizeRowScalar(src + i, dst + i, count - i, scale, bias);
+}
+
+static auto SelectQuantizeRow() -> QuantizeRowFunction {
+    return QuantizeRowNeon;
+}
+
+#elif defined(__x86_64__) || defined(__i386__)
+
+static auto QuantizeRowSse2(const float *src, uint8_t *dst, size_t count,
+                            float scale, float bias) -> void {
+    const auto zero = _mm_setzero_ps();
+    const auto max = _mm_set1_ps(255.0f);
+    const auto vScale = _mm_set1_ps(scale);
+    const auto vBias = _mm_set1_ps(bias);
+    const auto half = _mm_set1_ps(0.5f);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i q[4];
+        for (int k = 0; k < 4; k++) {
+            auto p = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src + i + k * 4), vScale), vBias);
+            q[k] = _mm_cvttps_epi32(_mm_add_ps(_mm_min_ps(_mm_max_ps(p, zero), max), half));
+        }
+
+        auto low = _mm_packs_epi32(q[0], q[1]);
+        auto high = _mm_packs_epi32(q[2], q[3]);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(low, high));
+    }
+
+    QuantizeRowScalar(src + i, dst + i, count - i, scale, bias);
+}
+
+__attribute__((target("avx2,fma")))
+static auto QuantizeRowAvx2(const float *src, uint8_t *dst, size_t count,
+                            float scale, float bias) -> void {
+    const auto zero = _mm256_setzero_ps();
+    const auto max = _mm256_set1_ps(255.0f);
+    const auto vScale = _mm256_set1_ps(scale);
+    const auto vBias = _mm256_set1_ps(bias);
+    const auto half = _mm256_set1_ps(0.5f);
+    // Packing works within 128-bit lanes, this puts the 32-bit groups back in order
+    const auto order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i q[4];
+        for (int k = 0; k < 4; k++) {
+            auto p = _mm256_fmadd_ps(_mm256_loadu_ps(src + i + k * 8), vScale, vBias);
+            q[k] = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_min_ps(_mm256_max_ps(p, zero), max),
+                                                     half));
+        }
+
+        auto low = _mm256_packs_epi32(q[0], q[1]);
+        auto high = _mm256_packs_epi32(q[2], q[3]);
+        auto bytes = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(low, high), order);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), bytes);
+    }
+
+    QuantizeRowScalar(src + i, dst + i, count - i, scale, bias);
+}
+
+static auto SelectQuantizeRow() -> QuantizeRowFunction {
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return QuantizeRowAvx2;
+    }
+    return QuantizeRowSse2;
+}
+
+#else
+
+static auto SelectQuantizeRow() -> QuantizeRowFunction {
+    return QuantizeRowScalar;
+}
+
+#endif
+
+// Mask values at once are gathered from multi-channel outputs into a buffer on the stack
+static constexpr int32_t kGatherSize = 256;
+
+template<typename T>
+static auto QuantizeMaskRows(const T *probabilities, int32_t modelWidth, uint8_t *mask,
+                             int32_t imageWidth, int32_t imageHeight,
+                             const Quantization &quantization, const OutputChannel &channel,
+                             QuantizeRowFunction quantizeRow) -> void {
+    // The image region is centered horizontally, skip the padding on both sides
+    const auto horizontalPadding = (modelWidth - imageWidth) / 2;
+    const auto stride = static_cast<size_t>(channel.channelCount);
+
+    // Dequantization and inversion fold into one affine transform of the stored value
+    auto scale = quantization.scale * 255.0f;
+    auto bias = -static_cast<float>(quantization.zeroPoint) * scale;
+    if (channel.invert) {
+        scale = -scale;
+        bias = 255.0f - bias;
+    }
+
+    if constexpr (sizeof(T) == 1) {
+        // 256 possible inputs, a lookup table beats any arithmetic
+        uint8_t table[256];
+        for (int32_t value = 0; value < 256; value++) {
+            table[value] = QuantizeValue(static_cast<float>(static_cast<T>(value)), scale, bias);
+        }
+
+        for (int32_t y = 0; y < imageHeight; y++) {
+            auto src = reinterpret_cast<const uint8_t *>(
+                    probabilities + (static_cast<size_t>(y) * modelWidth + horizontalPadding) *
+                                    stride + channel.personChannel);
+            auto dst = mask + y * imageWidth;
+            for (int32_t x = 0; x < imageWidth; x++) {
+                dst[x] = table[src[x * stride]];
+            }
+        }
+    } else if constexpr (std::is_same<T, Half>::value) {
+        for (int32_t y = 0; y < imageHeight; y++) {
+            auto src = probabilities + (static_cast<size_t>(y) * modelWidth + horizontalPadding) *
+                                       stride + channel.personChannel;
+            auto dst = mask + y * imageWidth;
+            for (int32_t x = 0; x < imageWidth; x++) {
+                dst[x] = QuantizeValue(FloatFromHalf(src[x * stride]), scale, bias);
+            }
+        }
+    } else if (stride == 1) {
+        for (int32_t y = 0; y < imageHeight; y++) {
+            quantizeRow(probabilities + y * modelWidth + horizontalPadding, mask + y * imageWidth,
+                        imageWidth, scale, bias);
+        }
+    } else {
+        float gathered[kGatherSize];
+        for (int32_t y = 0; y < imageHeight; y++) {
+            auto src = probabilities + (static_cast<size_t>(y) * modelWidth + horizontalPadding) *
+                                       stride + channel.personChannel;
+            auto dst = mask + y * imageWidth;
+            for (int32_t x = 0; x < imageWidth; x += kGatherSize) {
+                auto count = std::min(kGatherSize, imageWidth - x);
+                for (int32_t i = 0; i < count; i++) {
+                    gathered[i] = src[(x + i) * stride];
+                }
+                quantizeRow(gathered, dst + x, count, scale, bias);
+            }
+        }
+    }
+}
+
+template<typename T>
+auto QuantizeMask(const T *probabilities, int32_t modelWidth, int32_t /*modelHeight*/,
+                  uint8_t *mask, int32_t imageWidth, int32_t imageHeight,
+                  const Quantization &quantization, const OutputChannel &channel) -> void {
+    static const auto quantizeRow = SelectQuantizeRow();
+
+    QuantizeMaskRows(probabilities, modelWidth, mask, imageWidth, imageHeight, quantization,
+                     channel, quantizeRow);
+}
+
+template<typename T>
+auto QuantizeMaskScalar(const T *probabilities, int32_t modelWidth, int32_t /*modelHeight*/,
+                        uint8_t *mask, int32_t imageWidth, int32_t imageHeight,
+                        const Quantization &quantization, const OutputChannel &channel) -> void {
+    QuantizeMaskRows(probabilities, modelWidth, mask, imageWidth, imageHeight, quantization,
+                     channel, QuantizeRowScalar);
+}
+
+template auto QuantizeMask<float>(const float *, int32_t, int32_t, uint8_t *, int32_t, int32_t,
+                                  const Quantization &, const OutputChannel &) -> void;
+template auto QuantizeMask<Half>(const Half *, int32_t, int32_t, uint8_t *, int32_t, int32_t,
+                                 const Quantization &, const OutputChannel &) -> void;
+template auto QuantizeMask<uint8_t>(const uint8_t *, int32_t, int32_t, uint8_t *, int32_t, int32_t,
+                                    const Quantization &, const OutputChannel &) -> void;
+template auto QuantizeMask<int8_t>(const int8_t *, int32_t, int32_t, uint8_t *, int32_t, int32_t,
+                                   const Quantization &, const OutputChannel &) -> void;
+
+template auto QuantizeMaskScalar<float>(const float *, int32_t, int32_t, uint8_t *, int32_t,
+                                        int32_t, const Quantization &,
+                                        const OutputChannel &) -> void;
+template auto QuantizeMaskScalar<Half>(const Half *, int32_t, int32_t, uint8_t *, int32_t,
+                                       int32_t, const Quantization &,
+                                       const OutputChannel &) -> void;
+template auto QuantizeMaskScalar<uint8_t>(const uint8_t *, int32_t, int32_t, uint8_t *, int32_t,
+                                          int32_t, const Quantization &,
+                                          const OutputChannel &) -> void;
+template auto QuantizeMaskScalar<int8_t>(const int8_t *, int32_t, int32_t, uint8_t *, int32_t,
+                                         int32_t, const Quantization &,
+                                         const OutputChannel &) -> void;
@@ -0,0 +1,40 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "TensorFormat.h"
+
+#include <cstdint>
+
+// Quantizes the person probabilities of the image region of a model output with element type T
+// (float, Half, uint8_t or int8_t) to an 8-bit single-channel soft mask, 0 for the background and
+// 255 for the person. 8-bit outputs are dequantized with quantization on the way, channel picks
+// the person probability out of multi-channel outputs. The image region is placed like
+// PadAndNormalize does, so the padding is cropped on the fly. Uses NEON, SSE2 or AVX2 for float
+// outputs and a lookup table for 8-bit ones. Instantiated for these four types in Postprocess.cpp.
+template<typename T>
+auto QuantizeMask(const T *probabilities, int32_t modelWidth, int32_t modelHeight,
+                  uint8_t *mask, int32_t imageWidth, int32_t imageHeight,
+                  const Quantization &quantization = {},
+                  const OutputChannel &channel = {}) -> void;
+
+// Portable reference implementation of QuantizeMask.
+template<typename T>
+auto QuantizeMaskScalar(const T *probabilities, int32_t modelWidth, int32_t modelHeight,
+                        uint8_t *mask, int32_t imageWidth, int32_t imageHeight,
+                        const Quantization &quantization = {},
+                        const OutputChannel &channel = {}) -> void;
@@ -0,0 +1,633 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Preprocess.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+template<typename T>
+using ConvertRowFunction = void (*)(const uint8_t *src, T *dst, size_t count,
+                                    float scale, float bias);
+
+// Converts a normalized value to the tensor element type. For 8-bit types the value is already
+// in the quantized range and gets rounded and saturated.
+template<typename T>
+static auto Store(float value) -> T;
+
+template<>
+auto Store<int8_t>(float value) -> int8_t {
+    return static_cast<int8_t>(std::min(std::max(std::floor(value + 0.5f), -128.0f), 127.0f));
+}
+
+template<>
+auto Store<uint8_t>(float value) -> uint8_t {
+    return static_cast<uint8_t>(std::min(std::max(value, 0.0f), 255.0f) + 0.5f);
+}
+
+template<>
+auto Store<float>(float value) -> float {
+    return value;
+}
+
+template<>
+auto Store<Half>(float value) -> Half {
+    return HalfFromFloat(value);
+}
+
+template<typename T>
+static auto ConvertRowScalar(const uint8_t *src, T *dst, size_t count,
+                             float scale, float bias) -> void {
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = Store<T>(static_cast<float>(src[i]) * scale + bias);
+    }
+}
+
+// RGBA rows take the same count of output values as RGB rows, the alpha channel is skipped
+template<typename T>
+static auto ConvertRgbaRowScalar(const uint8_t *src, T *dst, size_t count,
+                                 float scale, float bias) -> void {
+    for (size_t i = 0; i < count / 3; i++) {
+        dst[i * 3] = Store<T>(static_cast<float>(src[i * 4]) * scale + bias);
+        dst[i * 3 + 1] = Store<T>(static_cast<float>(src[i * 4 + 1]) * scale + bias);
+        dst[i * 3 + 2] = Store<T>(static_cast<float>(src[i * 4 + 2]) * scale + bias);
+    }
+}
+
+// Half precision only has the portable path, the vector kernels cover float and 8-bit tensors
+template<typename T>
+static auto SelectConvertRow() -> ConvertRowFunction<T> {
+    return ConvertRowScalar<T>;
+}
+
+template<typename T>
+static auto SelectConvertRgbaRow() -> ConvertRowFunction<T> {
+    return ConvertRgbaRowScalar<T>;
+}
+
+// The 8-bit kernels quantize into [0, 255]; int8 values are computed shifted by 128 and the sign
+// bit is flipped on store, which maps [0, 255] back onto [-128, 127]
+template<typename T>
+static constexpr auto ByteOffset() -> float {
+    return std::is_signed<T>::value ? 128.0f : 0.0f;
+}
+
+template<typename T>
+static constexpr auto ByteFlip() -> uint8_t {
+    return std::is_signed<T>::value ? 0x80 : 0x00;
+}
+
+#if defined(__ARM_NEON)
+
+static auto ConvertRowNeon(const uint8_t *src, float *dst, size_t count,
+                           float scale, float bias) -> void {
+    const auto vScale = vdupq_n_f32(scale);
+    const auto vBias = vdupq_n_f32(bias);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        auto bytes = vld1q_u8(src + i);
+        auto low = vmovl_u8(vget_low_u8(bytes));
+        auto high = vmovl_u8(vget_high_u8(bytes));
+
+        auto f0 = vcvtq_f32_u32(vmovl_u16(vget_low_u16(low)));
+        auto f1 = vcvtq_f32_u32(vmovl_u16(vget_high_u16(low)));
+        auto f2 = vcvtq_f32_u32(vmovl_u16(vget_low_u16(high)));
+        auto f3 = vcvtq_f32_u32(vmovl_u16(vget_high_u16(high)));
+
+        vst1q_f32(dst + i, vmlaq_f32(vBias, f0, vScale));
+        vst1q_f32(dst + i + 4, vmlaq_f32(vBias, f1, vScale));
+        vst1q_f32(dst + i + 8, vmlaq_f32(vBias, f2, vScale));
+        vst1q_f32(dst + i + 12, vmlaq_f32(vBias, f3, vScale));
+    }
+
+    ConvertRowScalar(src + i, dst + i, count - i, scale, bias);
+}
+
+// Widens 16 bytes to four vectors of floats
+static inline auto WidenNeon(uint8x16_t bytes, float32x4_t *f) -> void {
+    auto low = vmovl_u8(vget_low_u8(bytes));
+    auto high = vmovl_u8(vget_high_u8(bytes));
+
+    f[0] = vcvtq_f32_u32(vmovl_u16(vget_low_u16(low)));
+    f[1] = vcvtq_f32_u32(vmovl_u16(vget_high_u16(low)));
+    f[2] = vcvtq_f32_u32(vmovl_u16(vget_low_u16(high)));
+    f[3] = vcvtq_f32_u32(vmovl_u16(vget_high_u16(high)));
+}
+
+// Converts 16 bytes to 16 quantized bytes, vBias includes ByteOffset() and flip ByteFlip()
+static inline auto ConvertBytesNeon(uint8x16_t bytes, float32x4_t vScale, float32x4_t vBias,
+                                    uint8x16_t flip) -> uint8x16_t {
+    const auto zero = vdupq_n_f32(0.0f);
+    const auto max = vdupq_n_f32(255.0f);
+    const auto half = vdupq_n_f32(0.5f);
+
+    float32x4_t f[4];
+    WidenNeon(bytes, f);
+    uint32x4_t q[4];
+    for (int k = 0; k < 4; k++) {
+        auto value = vminq_f32(vmaxq_f32(vmlaq_f32(vBias, f[k], vScale), zero), max);
+        q[k] = vcvtq_u32_f32(vaddq_f32(value, half));
+    }
+
+    auto low16 = vcombine_u16(vmovn_u32(q[0]), vmovn_u32(q[1]));
+    auto high16 = vcombine_u16(vmovn_u32(q[2]), vmovn_u32(q[3]));
+    return veorq_u8(vcombine_u8(vmovn_u16(low16), vmovn_u16(high16)), flip);
+}
+
+template<typename T>
+static auto ConvertRowBytesNeon(const uint8_t *src, T *dst, size_t count,
+                                float scale, float bias) -> void {
+    const auto vScale = vdupq_n_f32(scale);
+    const auto vBias = vdupq_n_f32(bias + ByteOffset<T>());
+    const auto flip = vdupq_n_u8(ByteFlip<T>());
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        auto result = ConvertBytesNeon(vld1q_u8(src + i), vScale, vBias, flip);
+        vst1q_u8(reinterpret_cast<uint8_t *>(dst + i), result);
+    }
+
+    ConvertRowScalar(src + i, dst + i, count - i, scale, bias);
+}
+
+// vld4 deinterleaves 16 RGBA pixels into one vector per channel, vst3 interleaves RGB again
+static auto ConvertRgbaRowNeon(const uint8_t *src, float *dst, size_t count,
+                               float scale, float bias) -> void {
+    const auto vScale = vdupq_n_f32(scale);
+    const auto vBias = vdupq_n_f32(bias);
+    const auto pixels = count / 3;
+
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16) {
+        auto rgba = vld4q_u8(src + i * 4);
+
+        float32x4_t f[3][4];
+        for (int c = 0; c < 3; c++) {
+            WidenNeon(rgba.val[c], f[c]);
+        }
+        for (int k = 0; k < 4; k++) {
+            float32x4x3_t rgb = {{vmlaq_f32(vBias, f[0][k], vScale),
+                                  vmlaq_f32(vBias, f[1][k], vScale),
+                                  vmlaq_f32(vBias, f[2][k], vScale)}};
+            vst3q_f32(dst + (i + k * 4) * 3, rgb);
+        }
+    }
+
+    ConvertRgbaRowScalar(src + i * 4, dst + i * 3, count - i * 3, scale, bias);
+}
+
+template<typename T>
+static auto ConvertRgbaRowBytesNeon(const uint8_t *src, T *dst, size_t count,
+                                    float scale, float bias) -> void {
+    const auto vScale = vdupq_n_f32(scale);
+    const auto vBias = vdupq_n_f32(bias + ByteOffset<T>());
+    const auto flip = vdupq_n_u8(ByteFlip<T>());
+    const auto pixels = count / 3;
+
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16) {
+        auto rgba = vld4q_u8(src + i * 4);
+
+        uint8x16x3_t rgb = {{ConvertBytesNeon(rgba.val[0], vScale, vBias, flip),
+                             ConvertBytesNeon(rgba.val[1], vScale, vBias, flip),
+                             ConvertBytesNeon(rgba.val[2], vScale, vBias, flip)}};
+        vst3q_u8(reinterpret_cast<uint8_t *>(dst + i * 3), rgb);
+    }
+
+    ConvertRgbaRowScalar(src + i * 4, dst + i * 3, count - i * 3, scale, bias);
+}
+
+template<>
+auto SelectConvertRow<float>() -> ConvertRowFunction<float> {
+    return ConvertRowNeon;
+}
+
+template<>
+auto SelectConvertRow<uint8_t>() -> ConvertRowFunction<uint8_t> {
+    return ConvertRowBytesNeon<uint8_t>;
+}
+
+template<>
+auto SelectConvertRow<int8_t>() -> ConvertRowFunction<int8_t> {
+    return ConvertRowBytesNeon<int8_t>;
+}
+
+template<>
+auto SelectConvertRgbaRow<float>() -> ConvertRowFunction<float> {
+    return ConvertRgbaRowNeon;
+}
+
+template<>
+auto SelectConvertRgbaRow<uint8_t>() -> ConvertRowFunction<uint8_t> {
+    return ConvertRgbaRowBytesNeon<uint8_t>;
+}
+
+template<>
+auto SelectConvertRgbaRow<int8_t>() -> ConvertRowFunction<int8_t> {
+    return ConvertRgbaRowBytesNeon<int8_t>;
+}
+
+#elif defined(__x86_64__) || defined(__i386__)
+
+static auto ConvertRowSse2(const uint8_t *src, float *dst, size_t count,
+                           float scale, float bias) -> void {
+    const auto vScale = _mm_set1_ps(scale);
+    const auto vBias = _mm_set1_ps(bias);
+    const auto zero = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        auto low = _mm_unpacklo_epi8(bytes, zero);
+        auto high = _mm_unpackhi_epi8(bytes, zero);
+
+        auto f0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero));
+        auto f1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero));
+        auto f2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero));
+        auto f3 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero));
+
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_mul_ps(f0, vScale), vBias));
+        _mm_storeu_ps(dst + i + 4, _mm_add_ps(_mm_mul_ps(f1, vScale), vBias));
+        _mm_storeu_ps(dst + i + 8, _mm_add_ps(_mm_mul_ps(f2, vScale), vBias));
+        _mm_storeu_ps(dst + i + 12, _mm_add_ps(_mm_mul_ps(f3, vScale), vBias));
+    }
+
+    ConvertRowScalar(src + i, dst + i, count - i, scale, bias);
+}
+
+// Widens 16 bytes to four vectors of 32-bit integers
+static inline auto WidenSse2(__m128i bytes, __m128i *words) -> void {
+    const auto zero = _mm_setzero_si128();
+    auto low = _mm_unpacklo_epi8(bytes, zero);
+    auto high = _mm_unpackhi_epi8(bytes, zero);
+
+    words[0] = _mm_unpacklo_epi16(low, zero);
+    words[1] = _mm_unpackhi_epi16(low, zero);
+    words[2] = _mm_unpacklo_epi16(high, zero);
+    words[3] = _mm_unpackhi_epi16(high, zero);
+}
+
+// Converts 16 bytes to 16 quantized bytes, vBias includes ByteOffset() and flip ByteFlip()
+static inline auto ConvertBytesSse2(__m128i bytes, __m128 vScale, __m128 vBias,
+                                    __m128i flip) -> __m128i {
+    const auto min = _mm_setzero_ps();
+    const auto max = _mm_set1_ps(255.0f);
+    const auto half = _mm_set1_ps(0.5f);
+
+    __m128i words[4];
+    WidenSse2(bytes, words);
+    __m128i q[4];
+    for (int k = 0; k < 4; k++) {
+        auto value = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(words[k]), vScale), vBias);
+        value = _mm_min_ps(_mm_max_ps(value, min), max);
+        q[k] = _mm_cvttps_epi32(_mm_add_ps(value, half));
+    }
+
+    auto packed = _mm_packus_epi16(_mm_packs_epi32(q[0], q[1]), _mm_packs_epi32(q[2], q[3]));
+    return _mm_xor_si128(packed, flip);
+}
+
+template<typename T>
+static auto ConvertRowBytesSse2(const uint8_t *src, T *dst, size_t count,
+                                float scale, float bias) -> void {
+    const auto vScale = _mm_set1_ps(scale);
+    const auto vBias = _mm_set1_ps(bias + ByteOffset<T>());
+    const auto flip = _mm_set1_epi8(static_cast<char>(ByteFlip<T>()));
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                         ConvertBytesSse2(bytes, vScale, vBias, flip));
+    }
+
+    ConvertRowScalar(src + i, dst + i, count - i, scale, bias);
+}
+
+// SSE2 has no byte shuffle: every pixel is stored with its alpha slot, which the next pixel
+// overwrites. The last pixel of the row has no successor and goes through the scalar loop.
+static auto ConvertRgbaRowSse2(const uint8_t *src, float *dst, size_t count,
+                               float scale, float bias) -> void {
+    const auto vScale = _mm_set1_ps(scale);
+    const auto vBias = _mm_set1_ps(bias);
+    const auto pixels = count / 3;
+
+    size_t i = 0;
+    for (; i + 5 <= pixels; i += 4) {
+        __m128i words[4];
+        WidenSse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4)), words);
+        for (int k = 0; k < 4; k++) {
+            auto value = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(words[k]), vScale), vBias);
+            _mm_storeu_ps(dst + (i + k) * 3, value);
+        }
+    }
+
+    ConvertRgbaRowScalar(src + i * 4, dst + i * 3, count - i * 3, scale, bias);
+}
+
+template<typename T>
+static auto ConvertRgbaRowBytesSse2(const uint8_t *src, T *dst, size_t count,
+                                    float scale, float bias) -> void {
+    const auto vScale = _mm_set1_ps(scale);
+    const auto vBias = _mm_set1_ps(bias + ByteOffset<T>());
+    const auto flip = _mm_set1_epi8(static_cast<char>(ByteFlip<T>()));
+    const auto pixels = count / 3;
+
+    size_t i = 0;
+    for (; i + 5 <= pixels; i += 4) {
+        auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4));
+        auto converted = ConvertBytesSse2(bytes, vScale, vBias, flip);
+        for (int k = 0; k < 4; k++) {
+            auto pixel = _mm_cvtsi128_si32(converted);
+            memcpy(dst + (i + k) * 3, &pixel, sizeof(pixel));
+            converted = _mm_srli_si128(converted, 4);
+        }
+    }
+
+    ConvertRgbaRowScalar(src + i * 4, dst + i * 3, count - i * 3, scale, bias);
+}
+
+__attribute__((target("avx2,fma")))
+static auto ConvertRowAvx2(const uint8_t *src, float *dst, size_t count,
+                           float scale, float bias) -> void {
+    const auto vScale = _mm256_set1_ps(scale);
+    const auto vBias = _mm256_set1_ps(bias);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+
+        auto f0 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+        auto f1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_unpackhi_epi64(bytes, bytes)));
+
+        _mm256_storeu_ps(dst + i, _mm256_fmadd_ps(f0, vScale, vBias));
+        _mm256_storeu_ps(dst + i + 8, _mm256_fmadd_ps(f1, vScale, vBias));
+    }
+
+    ConvertRowScalar(src + i, dst + i, count - i, scale, bias);
+}
+
+// Converts 16 bytes to 16 quantized bytes, vBias includes ByteOffset() and flip ByteFlip()
+__attribute__((target("avx2,fma")))
+static inline auto ConvertBytesAvx2(__m128i bytes, __m256 vScale, __m256 vBias,
+                                    __m128i flip) -> __m128i {
+    const auto min = _mm256_setzero_ps();
+    const auto max = _mm256_set1_ps(255.0f);
+    const auto half = _mm256_set1_ps(0.5f);
+
+    __m256i q[2];
+    __m128i halves[2] = {bytes, _mm_unpackhi_epi64(bytes, bytes)};
+    for (int k = 0; k < 2; k++) {
+        auto value = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(halves[k]));
+        value = _mm256_min_ps(_mm256_max_ps(_mm256_fmadd_ps(value, vScale, vBias), min), max);
+        q[k] = _mm256_cvttps_epi32(_mm256_add_ps(value, half));
+    }
+
+    // Packing works within 128-bit lanes, put the 64-bit groups back in order
+    auto words = _mm256_permute4x64_epi64(_mm256_packs_epi32(q[0], q[1]), 0xd8);
+    auto packed = _mm_packus_epi16(_mm256_castsi256_si128(words),
+                                   _mm256_extracti128_si256(words, 1));
+    return _mm_xor_si128(packed, flip);
+}
+
+template<typename T>
+__attribute__((target("avx2,fma")))
+static auto ConvertRowBytesAvx2(const uint8_t *src, T *dst, size_t count,
+                                float scale, float bias) -> void {
+    const auto vScale = _mm256_set1_ps(scale);
+    const auto vBias = _mm256_set1_ps(bias + ByteOffset<T>());
+    const auto flip = _mm_set1_epi8(static_cast<char>(ByteFlip<T>()));
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                         ConvertBytesAvx2(bytes, vScale, vBias, flip));
+    }
+
+    ConvertRowScalar(src + i, dst + i, count - i, scale, bias);
+}
+
+// Packs the RGB bytes of 4 RGBA pixels into the low 12 bytes
+__attribute__((target("avx2,fma")))
+static inline auto DropAlphaAvx2(__m128i rgba) -> __m128i {
+    const auto order = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    return _mm_shuffle_epi8(rgba, order);
+}
+
+__attribute__((target("avx2,fma")))
+static auto ConvertRgbaRowAvx2(const uint8_t *src, float *dst, size_t count,
+                               float scale, float bias) -> void {
+    const auto vScale = _mm256_set1_ps(scale);
+    const auto vBias = _mm256_set1_ps(bias);
+    const auto pixels = count / 3;
+
+    size_t i = 0;
+    for (; i + 4 <= pixels; i += 4) {
+        auto rgb = DropAlphaAvx2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4)));
+
+        auto f0 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(rgb));
+        auto f1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_unpackhi_epi64(rgb, rgb)));
+
+        _mm256_storeu_ps(dst + i * 3, _mm256_fmadd_ps(f0, vScale, vBias));
+        _mm_storeu_ps(dst + i * 3 + 8, _mm256_castps256_ps128(_mm256_fmadd_ps(f1, vScale, vBias)));
+    }
+
+    ConvertRgbaRowScalar(src + i * 4, dst + i * 3, count - i * 3, scale, bias);
+}
+
+template<typename T>
+__attribute__((target("avx2,fma")))
+static auto ConvertRgbaRowBytesAvx2(const uint8_t *src, T *dst, size_t count,
+                                    float scale, float bias) -> void {
+    const auto vScale = _mm256_set1_ps(scale);
+    const auto vBias = _mm256_set1_ps(bias + ByteOffset<T>());
+    const auto flip = _mm_set1_epi8(static_cast<char>(ByteFlip<T>()));
+    const auto pixels = count / 3;
+
+    size_t i = 0;
+    for (; i + 4 <= pixels; i += 4) {
+        auto rgb = DropAlphaAvx2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4)));
+        auto converted = ConvertBytesAvx2(rgb, vScale, vBias, flip);
+
+        auto out = reinterpret_cast<uint8_t *>(dst + i * 3);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(out), converted);
+        auto last = _mm_cvtsi128_si32(_mm_srli_si128(converted, 8));
+        memcpy(out + 8, &last, sizeof(last));
+    }
+
+    ConvertRgbaRowScalar(src + i * 4, dst + i * 3, count - i * 3, scale, bias);
+}
+
+static auto HasAvx2() -> bool {
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+template<>
+auto SelectConvertRow<float>() -> ConvertRowFunction<float> {
+    return HasAvx2() ? ConvertRowAvx2 : ConvertRowSse2;
+}
+
+template<>
+auto SelectConvertRow<uint8_t>() -> ConvertRowFunction<uint8_t> {
+    return HasAvx2() ? ConvertRowBytesAvx2<uint8_t> : ConvertRowBytesSse2<uint8_t>;
+}
+
+template<>
+auto SelectConvertRow<int8_t>() -> ConvertRowFunction<int8_t> {
+    return HasAvx2() ? ConvertRowBytesAvx2<int8_t> : ConvertRowBytesSse2<int8_t>;
+}
+
+template<>
+auto SelectConvertRgbaRow<float>() -> ConvertRowFunction<float> {
+    return HasAvx2() ? ConvertRgbaRowAvx2 : ConvertRgbaRowSse2;
+}
+
+template<>
+auto SelectConvertRgbaRow<uint8_t>() -> ConvertRowFunction<uint8_t> {
+    return HasAvx2() ? ConvertRgbaRowBytesAvx2<uint8_t> : ConvertRgbaRowBytesSse2<uint8_t>;
+}
+
+template<>
+auto SelectConvertRgbaRow<int8_t>() -> ConvertRowFunction<int8_t> {
+    return HasAvx2() ? ConvertRgbaRowBytesAvx2<int8_t> : ConvertRgbaRowBytesSse2<int8_t>;
+}
+
+#endif
+
+template<typename T>
+static auto PadAndNormalizeRows(const uint8_t *image, int32_t imageWidth, int32_t imageHeight,
+                                int32_t channels, T *input, int32_t modelWidth,
+                                int32_t modelHeight, float mean, float stddev,
+                                const Quantization &quantization,
+                                ConvertRowFunction<T> convertRow) -> void {
+    auto scale = 1.0f / stddev;
+    auto bias = -mean / stddev;
+
+    // Quantization folds into the same affine transform
+    if (std::is_integral<T>::value) {
+        scale /= quantization.scale;
+        bias = bias / quantization.scale + static_cast<float>(quantization.zeroPoint);
+    }
+
+    const auto padding = Store<T>(bias);
+
+    const auto srcRowSize = static_cast<size_t>(imageWidth) * channels;
+    const auto rowSize = static_cast<size_t>(imageWidth) * 3;
+    const auto dstRowSize = static_cast<size_t>(modelWidth) * 3;
+    const auto leftPadding = static_cast<size_t>((modelWidth - imageWidth) / 2) * 3;
+    const auto rightPadding = dstRowSize - rowSize - leftPadding;
+
+    for (int32_t y = 0; y < imageHeight; y++) {
+        auto dst = input + y * dstRowSize;
+
+        std::fill_n(dst, leftPadding, padding);
+        convertRow(image + y * srcRowSize, dst + leftPadding, rowSize, scale, bias);
+        std::fill_n(dst + leftPadding + rowSize, rightPadding, padding);
+    }
+
+    // Rows below the image are padding as a whole
+    std::fill(input + imageHeight * dstRowSize, input + modelHeight * dstRowSize, padding);
+}
+
+template<typename T>
+auto PadAndNormalize(const uint8_t *image, int32_t imageWidth, int32_t imageHeight,
+                     T *input, int32_t modelWidth, int32_t modelHeight,
+                     float mean, float stddev, const Quantization &quantization) -> void {
+    static const auto convertRow = SelectConvertRow<T>();
+
+    PadAndNormalizeRows(image, imageWidth, imageHeight, 3, input, modelWidth, modelHeight,
+                        mean, stddev, quantization, convertRow);
+}
+
+template<typename T>
+auto PadAndNormalizeScalar(const uint8_t *image, int32_t imageWidth, int32_t imageHeight,
+                           T *input, int32_t modelWidth, int32_t modelHeight,
+                           float mean, float stddev, const Quantization &quantization) -> void {
+    PadAndNormalizeRows(image, imageWidth, imageHeight, 3, input, modelWidth, modelHeight,
+                        mean, stddev, quantization, ConvertRowScalar<T>);
+}
+
+template<typename T>
+auto PadAndNormalizeRgba(const uint8_t *image, int32_t imageWidth, int32_t imageHeight,
+                         T *input, int32_t modelWidth, int32_t modelHeight,
+                         float mean, float stddev, const Quantization &quantization) -> void {
+    static const auto convertRow = SelectConvertRgbaRow<T>();
+
+    PadAndNormalizeRows(image, imageWidth, imageHeight, 4, input, modelWidth, modelHeight,
+                        mean, stddev, quantization, convertRow);
+}
+
+template<typename T>
+auto PadAndNormalizeRgbaScalar(const uint8_t *image, int32_t imageWidth, int32_t imageHeight,
+                               T *input, int32_t modelWidth, int32_t modelHeight,
+                               float mean, float stddev,
+                               const Quantization &quantization) -> void {
+    PadAndNormalizeRows(image, imageWidth, imageHeight, 4, input, modelWidth, modelHeight,
+                        mean, stddev, quantization, ConvertRgbaRowScalar<T>);
+}
+
+template auto PadAndNormalize<float>(const uint8_t *, int32_t, int32_t, float *, int32_t, int32_t,
+                                     float, float, const Quantization &) -> void;
+template auto PadAndNormalize<Half>(const uint8_t *, int32_t, int32_t, Half *, int32_t, int32_t,
+                                    float, float, const Quantization &) -> void;
+template auto PadAndNormalize<uint8_t>(const uint8_t *, int32_t, int32_t, uint8_t *, int32_t,
+                                       int32_t, float, float, const Quantization &) -> void;
+template auto PadAndNormalize<int8_t>(const uint8_t *, int32_t, int32_t, int8_t *, int32_t,
+                                      int32_t, float, float, const Quantization &) -> void;
+
+template auto PadAndNormalizeScalar<float>(const uint8_t *, int32_t, int32_t, float *, int32_t,
+                                           int32_t, float, float, const Quantization &) -> void;
+template auto PadAndNormalizeScalar<Half>(const uint8_t *, int32_t, int32_t, Half *, int32_t,
+                                          int32_t, float, float, const Quantization &) -> void;
+template auto PadAndNormalizeScalar<uint8_t>(const uint8_t *, int32_t, int32_t, uint8_t *,
+                                             int32_t, int32_t, float, float,
+                                             const Quantization &) -> void;
+template auto PadAndNormalizeScalar<int8_t>(const uint8_t *, int32_t, int32_t, int8_t *,
+                                            int32_t, int32_t, float, float,
+                                            const Quantization &) -> void;
+
+template auto PadAndNormalizeRgba<float>(const uint8_t *, int32_t, int32_t, float *, int32_t,
+                                         int32_t, float, float, const Quantization &) -> void;
+template auto PadAndNormalizeRgba<Half>(const uint8_t *, int32_t, int32_t, Half *, int32_t,
+                                        int32_t, float, float, const Quantization &) -> void;
+template auto PadAndNormalizeRgba<uint8_t>(const uint8_t *, int32_t, int32_t, uint8_t *, int32_t,
+                                           int32_t, float, float, const Quantization &) -> void;
+template auto PadAndNormalizeRgba<int8_t>(const uint8_t *, int32_t, int32_t, int8_t *, int32_t,
+                                          int32_t, float, float, const Quantization &) -> void;
+
+template auto PadAndNormalizeRgbaScalar<float>(const uint8_t *, int32_t, int32_t, float *,
+                                               int32_t, int32_t, float, float,
+                                               const Quantization &) -> void;
+template auto PadAndNormalizeRgbaScalar<Half>(const uint8_t *, int32_t, int32_t, Half *,
+                                              int32_t, int32_t, float, float,
+                                              const Quantization &) -> void;
+template auto PadAndNormalizeRgbaScalar<uint8_t>(const uint8_t *, int32_t, int32_t, uint8_t *,
+                                                 int32_t, int32_t, float, float,
+                                                 const Quantization &) -> void;
+template auto PadAndNormalizeRgbaScalar<int8_t>(const uint8_t *, int32_t, int32_t, int8_t *,
+                                                int32_t, int32_t, float, float,
+                                                const Quantization &) -> void;
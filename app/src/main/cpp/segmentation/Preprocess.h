@@ -0,0 +1,53 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "TensorFormat.h"
+
+#include <cstdint>
+
+// Writes a 3-channel image straight into a model input of modelWidth x modelHeight pixels with
+// element type T (float, Half, uint8_t or int8_t), normalizing every channel value to
+// (value - mean) / stddev and quantizing the result for 8-bit inputs. The image is placed at the
+// top and centered horizontally, only the padding bands around it are filled with the normalized
+// zero value. An image of the model size, letterboxed already, is normalized as a whole. Uses
+// NEON, SSE2 or AVX2 for float and 8-bit inputs when available. Instantiated for these four
+// types in Preprocess.cpp.
+template<typename T>
+auto PadAndNormalize(const uint8_t *image, int32_t imageWidth, int32_t imageHeight,
+                     T *input, int32_t modelWidth, int32_t modelHeight,
+                     float mean, float stddev, const Quantization &quantization = {}) -> void;
+
+// Portable reference implementation of PadAndNormalize.
+template<typename T>
+auto PadAndNormalizeScalar(const uint8_t *image, int32_t imageWidth, int32_t imageHeight,
+                           T *input, int32_t modelWidth, int32_t modelHeight,
+                           float mean, float stddev, const Quantization &quantization = {}) -> void;
+
+// PadAndNormalize for 4-channel RGBA images, as read back from the GPU. The alpha channel is
+// dropped in the same pass. Uses NEON, SSE2 or AVX2 for float and 8-bit inputs when available.
+template<typename T>
+auto PadAndNormalizeRgba(const uint8_t *image, int32_t imageWidth, int32_t imageHeight,
+                         T *input, int32_t modelWidth, int32_t modelHeight,
+                         float mean, float stddev, const Quantization &quantization = {}) -> void;
+
+// Portable reference implementation of PadAndNormalizeRgba.
+template<typename T>
+auto PadAndNormalizeRgbaScalar(const uint8_t *image, int32_t imageWidth, int32_t imageHeight,
+                               T *input, int32_t modelWidth, int32_t modelHeight,
+                               float mean, float stddev,
+                               const Quantization &quantization = {}) -> void;
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "RegionTracker.h"
+
+#include <algorithm>
+
+static constexpr float kDefaultMargin = 0.25f;
+
+// Mask values from this one on count as the person
+static constexpr uint8_t kPersonThreshold = 128;
+
+// Fewer person pixels than this fraction of the mask means the person is lost
+static constexpr float kMinCoverage = 0.005f;
+
+// Keeps the zoom at 3x at most, the model gains nothing from upscaled pixels
+static constexpr float kMinSize = 1.0f / 3.0f;
+
+// A new region inside the current one replaces it only when it is this much smaller
+static constexpr float kShrinkRatio = 0.7f;
+
+RegionTracker::RegionTracker()
+        : m_margin(kDefaultMargin),
+          m_region(kFullFrame),
+          m_tracking(false) {
+}
+
+auto RegionTracker::SetMargin(float margin) -> void {
+    m_margin = margin;
+}
+
+auto RegionTracker::Reset() -> void {
+    m_region = kFullFrame;
+    m_tracking = false;
+}
+
+auto RegionTracker::Update(const uint8_t *mask, int32_t width, int32_t height, int32_t stride,
+                           const MaskRegion &maskRegion) -> void {
+    auto left = width;
+    auto top = height;
+    auto right = -1;
+    auto bottom = -1;
+    size_t count = 0;
+
+    for (int32_t y = 0; y < height; y++) {
+        auto row = mask + static_cast<size_t>(y) * stride;
+        auto rowCount = count;
+        for (int32_t x = 0; x < width; x++) {
+            if (row[x] >= kPersonThreshold) {
+                left = std::min(left, x);
+                right = std::max(right, x);
+                count++;
+            }
+        }
+        if (count != rowCount) {
+            top = std::min(top, y);
+            bottom = y;
+        }
+    }
+
+    if (static_cast<float>(count) < kMinCoverage * static_cast<float>(width) * height) {
+        Reset();
+        return;
+    }
+
+    // Bounding box in frame coordinates, grown by the margin
+    auto boxWidth = static_cast<float>(right + 1 - left) / width * maskRegion.width;
+    auto boxHeight = static_cast<float>(bottom + 1 - top) / height * maskRegion.height;
+    auto centerX = maskRegion.x + (static_cast<float>(left + right + 1) * 0.5f) / width *
+                                  maskRegion.width;
+    auto centerY = maskRegion.y + (static_cast<float>(top + bottom + 1) * 0.5f) / height *
+                                  maskRegion.height;
+    auto size = std::max(boxWidth, boxHeight) * (1.0f + 2.0f * m_margin);
+
+    if (size >= 1.0f) {
+        m_region = kFullFrame;
+        m_tracking = true;
+        return;
+    }
+
+    size = std::max(size, kMinSize);
+    MaskRegion region = {
+            std::min(std::max(centerX - size * 0.5f, 0.0f), 1.0f - size),
+            std::min(std::max(centerY - size * 0.5f, 0.0f), 1.0f - size),
+            size,
+            size
+    };
+
+    auto inside = region.x >= m_region.x && region.y >= m_region.y &&
+                  region.x + region.width <= m_region.x + m_region.width &&
+                  region.y + region.height <= m_region.y + m_region.height;
+    if (!m_tracking || !inside || region.width < kShrinkRatio * m_region.width) {
+        m_region = region;
+    }
+    m_tracking = true;
+}
+
+auto RegionTracker::Current() const -> const MaskRegion & {
+    return m_region;
+}
+
+auto RegionTracker::IsTracking() const -> bool {
+    return m_tracking;
+}
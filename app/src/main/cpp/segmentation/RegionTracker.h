@@ -0,0 +1,68 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+// Rectangle of the camera frame in normalized mask coordinates, x to the right and y along the
+// mask rows. {0, 0, 1, 1} is the full frame.
+struct MaskRegion {
+    float x;
+    float y;
+    float width;
+    float height;
+};
+
+inline auto operator==(const MaskRegion &a, const MaskRegion &b) -> bool {
+    return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+inline auto operator!=(const MaskRegion &a, const MaskRegion &b) -> bool {
+    return !(a == b);
+}
+
+// Follows the person from mask to mask so the model only sees the part of the frame around them.
+// The next region is the bounding box of the person in the last mask, grown by a margin and made
+// square in normalized coordinates, so it keeps the aspect ratio of the frame and of the model
+// tile. Small changes are ignored to keep the region steady. When the mask loses the person the
+// region falls back to the full frame.
+class RegionTracker {
+public:
+    static constexpr MaskRegion kFullFrame = {0.0f, 0.0f, 1.0f, 1.0f};
+
+    RegionTracker();
+
+    // margin is the fraction of the bounding box size added on every side.
+    auto SetMargin(float margin) -> void;
+
+    auto Reset() -> void;
+
+    // mask of width x height pixels, with rows stride pixels apart, covers maskRegion of the
+    // frame.
+    auto Update(const uint8_t *mask, int32_t width, int32_t height, int32_t stride,
+                const MaskRegion &maskRegion) -> void;
+
+    // Region the next frame should be segmented in.
+    auto Current() const -> const MaskRegion &;
+
+    auto IsTracking() const -> bool;
+
+private:
+    float m_margin;
+    MaskRegion m_region;
+    bool m_tracking;
+};
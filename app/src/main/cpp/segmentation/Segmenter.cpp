@@ -0,0 +1,384 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Segmenter.h"
+
+#include "Log.h"
+#include "Postprocess.h"
+#include "Preprocess.h"
+#include "Trace.h"
+
+#include <cinttypes>
+#include <chrono>
+#include <cstdio>
+
+#include <tensorflow/lite/core/interpreter_builder.h>
+#include <tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h>
+#include <tensorflow/lite/kernels/register.h>
+#include <tensorflow/lite/core/api/op_resolver.h>
+
+// The mean invoke time is logged once after this many invokes, when the caches are warm
+static constexpr uint64_t kLatencyLogInvokes = 100;
+
+// Weight of the latest invoke in RecentInvokeTime(), about the last 20 invokes count
+static constexpr float kRecentInvokeWeight = 0.1f;
+
+Segmenter::Segmenter()
+        : m_pDelegate(nullptr, TfLiteXNNPackDelegateDelete),
+          m_preprocess(nullptr),
+          m_preprocessRgba(nullptr),
+          m_postprocess(nullptr),
+          m_mean(0.0f),
+          m_stddev(1.0f),
+          m_filterRegion(RegionTracker::kFullFrame),
+          m_width(0),
+          m_height(0),
+          m_copiedBytes(0),
+          m_invokeCount(0),
+          m_invokeTime(0),
+          m_recentInvokeTime(0.0f) {
+}
+
+Segmenter::~Segmenter() = default;
+
+template<typename T>
+static auto Preprocess(const uint8_t *image, int32_t imageWidth, int32_t imageHeight, void *input,
+                       int32_t modelWidth, int32_t modelHeight, float mean, float stddev,
+                       const Quantization &quantization) -> void {
+    PadAndNormalize(image, imageWidth, imageHeight, static_cast<T *>(input), modelWidth,
+                    modelHeight, mean, stddev, quantization);
+}
+
+template<typename T>
+static auto PreprocessRgba(const uint8_t *image, int32_t imageWidth, int32_t imageHeight,
+                           void *input, int32_t modelWidth, int32_t modelHeight, float mean,
+                           float stddev, const Quantization &quantization) -> void {
+    PadAndNormalizeRgba(image, imageWidth, imageHeight, static_cast<T *>(input), modelWidth,
+                        modelHeight, mean, stddev, quantization);
+}
+
+template<typename T>
+static auto Postprocess(const void *output, int32_t modelWidth, int32_t modelHeight,
+                        uint8_t *mask, int32_t imageWidth, int32_t imageHeight,
+                        const Quantization &quantization, const OutputChannel &channel) -> void {
+    QuantizeMask(static_cast<const T *>(output), modelWidth, modelHeight, mask, imageWidth,
+                 imageHeight, quantization, channel);
+}
+
+template<typename Function>
+static auto SelectKernel(TfLiteType type, Function float32, Function float16, Function uint8,
+                         Function int8) -> Function {
+    switch (type) {
+        case kTfLiteFloat32:
+            return float32;
+        case kTfLiteFloat16:
+            return float16;
+        case kTfLiteUInt8:
+            return uint8;
+        case kTfLiteInt8:
+            return int8;
+        default:
+            return nullptr;
+    }
+}
+
+auto Segmenter::Initialize(std::unique_ptr<ModelFile> pModelFile, const ModelDescriptor &model,
+                           const InferenceOptions &options) -> bool {
+    // Release the previous model in reverse order of creation, the interpreter goes first
+    m_pInterpreter.reset();
+    m_pDelegate.reset();
+    m_pModel.reset();
+    m_inputQuantization = {};
+    m_outputQuantization = {};
+    m_invokeCount = 0;
+    m_invokeTime = 0;
+    m_recentInvokeTime = 0.0f;
+
+    m_pModelFile = std::move(pModelFile);
+    m_pModel = tflite::FlatBufferModel::BuildFromBuffer(m_pModelFile->Data(),
+                                                        m_pModelFile->Size());
+    if (!m_pModel) {
+        LOGE("Could not build model.\n");
+        return false;
+    }
+
+    // XNNPACK is applied below with our options, keep the resolver from adding its default one
+    tflite::ops::builtin::BuiltinOpResolverWithoutDefaultDelegates resolver;
+    tflite::InterpreterBuilder(*m_pModel, resolver)(&m_pInterpreter);
+
+    if (!m_pInterpreter) {
+        LOGE("Could not create interpreter.\n");
+        return false;
+    }
+
+    m_pInterpreter->SetNumThreads(options.threadCount);
+    m_pInterpreter->SetAllowFp16PrecisionForFp32(options.allowFp16);
+
+    auto backend = "builtin kernels";
+    if (options.useXnnpack) {
+        if (ApplyXnnpack(model, options)) {
+            backend = "XNNPACK";
+        } else if (options.fallbackToBuiltinKernels) {
+            LOGE("Could not apply XNNPACK delegate, falling back to builtin kernels.\n");
+        } else {
+            LOGE("Could not apply XNNPACK delegate.\n");
+            m_pInterpreter.reset();
+            return false;
+        }
+    }
+
+    if (m_pInterpreter->AllocateTensors() != kTfLiteOk) {
+        LOGE("Could not create interpreter.\n");
+        m_pInterpreter.reset();
+        return false;
+    }
+
+    if (!CheckTensors(model)) {
+        m_pInterpreter.reset();
+        return false;
+    }
+
+    auto tensorInputIndex = m_pInterpreter->inputs()[0];
+    auto tensorOutputIndex = m_pInterpreter->outputs()[0];
+    m_height = model.height;
+    m_width = model.width;
+    m_mean = model.mean;
+    m_stddev = model.stddev;
+    m_outputChannel = {model.outputChannels, model.personChannel, model.invertPerson};
+
+    // Hand the interpreter our own aligned buffers for the input and output tensors, so the
+    // pre/post-processing kernels work on them directly
+    m_input.Allocate(m_pInterpreter->tensor(tensorInputIndex)->bytes);
+    m_output.Allocate(m_pInterpreter->tensor(tensorOutputIndex)->bytes);
+
+    if (!SelectKernels()) {
+        m_pInterpreter.reset();
+        return false;
+    }
+
+    if (m_pInterpreter->SetCustomAllocationForTensor(
+            tensorInputIndex, {m_input.Data(), m_input.Size()}) != kTfLiteOk ||
+        m_pInterpreter->SetCustomAllocationForTensor(
+                tensorOutputIndex, {m_output.Data(), m_output.Size()}) != kTfLiteOk ||
+        m_pInterpreter->AllocateTensors() != kTfLiteOk) {
+        LOGE("Could not set custom tensor allocations.\n");
+        m_pInterpreter.reset();
+        return false;
+    }
+
+    LOGI("Model %s %dx%d, inference on %s, %d thread(s), FP16 %s, weight cache %s\n",
+         model.name, m_width, m_height, backend,
+         options.threadCount,
+         options.forceFp16 ? "forced" : options.allowFp16 ? "allowed" : "disabled",
+         m_weightCachePath.empty() ? "disabled" : m_weightCachePath.c_str());
+
+    if (options.warmUp) {
+        WarmUp();
+    }
+
+    return true;
+}
+
+auto Segmenter::CheckTensors(const ModelDescriptor &model) const -> bool {
+    const auto input = m_pInterpreter->tensor(m_pInterpreter->inputs()[0]);
+    const auto output = m_pInterpreter->tensor(m_pInterpreter->outputs()[0]);
+
+    // NHWC input [1, height, width, 3] and output [1, height, width, channels]
+    const auto matches = [&model](const TfLiteTensor *tensor, int32_t channels) {
+        return tensor->dims->size == 4 && tensor->dims->data[1] == model.height &&
+               tensor->dims->data[2] == model.width && tensor->dims->data[3] == channels;
+    };
+
+    if (!matches(input, 3) || !matches(output, model.outputChannels) ||
+        model.personChannel < 0 || model.personChannel >= model.outputChannels) {
+        LOGE("Model %s: tensors do not match the descriptor %dx%d with %d output channel(s)\n",
+             model.name, model.width, model.height, model.outputChannels);
+        return false;
+    }
+
+    return true;
+}
+
+auto Segmenter::SelectKernels() -> bool {
+    const auto input = m_pInterpreter->tensor(m_pInterpreter->inputs()[0]);
+    const auto output = m_pInterpreter->tensor(m_pInterpreter->outputs()[0]);
+
+    m_preprocess = SelectKernel<PreprocessFunction>(
+            input->type, Preprocess<float>, Preprocess<Half>, Preprocess<uint8_t>,
+            Preprocess<int8_t>);
+    m_preprocessRgba = SelectKernel<PreprocessFunction>(
+            input->type, PreprocessRgba<float>, PreprocessRgba<Half>, PreprocessRgba<uint8_t>,
+            PreprocessRgba<int8_t>);
+    m_postprocess = SelectKernel<PostprocessFunction>(
+            output->type, Postprocess<float>, Postprocess<Half>, Postprocess<uint8_t>,
+            Postprocess<int8_t>);
+
+    if (m_preprocess == nullptr || m_postprocess == nullptr) {
+        LOGE("Unsupported tensor types: input %s, output %s\n", TfLiteTypeGetName(input->type),
+             TfLiteTypeGetName(output->type));
+        return false;
+    }
+
+    // Float tensors carry no quantization, keep the identity for them
+    if (input->type == kTfLiteUInt8 || input->type == kTfLiteInt8) {
+        m_inputQuantization = {input->params.scale, input->params.zero_point};
+    }
+    if (output->type == kTfLiteUInt8 || output->type == kTfLiteInt8) {
+        m_outputQuantization = {output->params.scale, output->params.zero_point};
+    }
+
+    LOGI("Input tensor %s (scale %g, zero point %d), output tensor %s (scale %g, zero point %d)\n",
+         TfLiteTypeGetName(input->type), m_inputQuantization.scale,
+         m_inputQuantization.zeroPoint, TfLiteTypeGetName(output->type),
+         m_outputQuantization.scale, m_outputQuantization.zeroPoint);
+
+    return true;
+}
+
+auto Segmenter::ApplyXnnpack(const ModelDescriptor &model,
+                             const InferenceOptions &options) -> bool {
+    auto delegateOptions = TfLiteXNNPackDelegateOptionsDefault();
+    if (options.threadCount > 0) {
+        delegateOptions.num_threads = options.threadCount;
+    }
+    // allowFp16 reaches XNNPACK through SetAllowFp16PrecisionForFp32(), which only takes effect
+    // on hardware with FP16 arithmetic
+    if (options.forceFp16) {
+        delegateOptions.flags |= TFLITE_XNNPACK_DELEGATE_FLAG_FORCE_FP16;
+    }
+
+    // Packed weights depend on the model contents and the precision. The file name carries the
+    // model name, a hash of the model bytes and the precision, so an updated model or another
+    // model of the same size gets a cache of its own
+    m_weightCachePath.clear();
+    if (!options.cacheDirectory.empty()) {
+        char hash[17];
+        snprintf(hash, sizeof(hash), "%016" PRIx64, m_pModelFile->ContentHash());
+        m_weightCachePath = options.cacheDirectory + "/xnnpack_weights_" + model.name + "_" +
+                            hash + (options.forceFp16 ? "_forcefp16" : "") +
+                            (options.allowFp16 ? "_fp16" : "") + ".bin";
+        delegateOptions.weight_cache_file_path = m_weightCachePath.c_str();
+    }
+
+    // A failed delegation leaves the graph untouched, the delegate is kept alive regardless
+    m_pDelegate.reset(TfLiteXNNPackDelegateCreate(&delegateOptions));
+    return m_pDelegate &&
+           m_pInterpreter->ModifyGraphWithDelegate(m_pDelegate.get()) == kTfLiteOk;
+}
+
+auto Segmenter::Width() const -> int32_t {
+    return m_width;
+}
+
+auto Segmenter::Height() const -> int32_t {
+    return m_height;
+}
+
+auto Segmenter::Segment(const std::vector<uint8_t> &image, int32_t imageWidth,
+                        int32_t imageHeight, int32_t channels, const MaskRegion &region,
+                        std::vector<uint8_t> &mask) -> void {
+    {
+        TRACE_SCOPE("Preprocess");
+        auto preprocess = channels == 4 ? m_preprocessRgba : m_preprocess;
+        preprocess(image.data(), imageWidth, imageHeight, m_input.Data(), m_width, m_height,
+                   m_mean, m_stddev, m_inputQuantization);
+    }
+
+    Invoke();
+
+    {
+        TRACE_SCOPE("Postprocess");
+        m_postprocess(m_output.Data(), m_width, m_height, mask.data(), imageWidth, imageHeight,
+                      m_outputQuantization, m_outputChannel);
+
+        if (m_temporalFilter.IsAllocated()) {
+            // The same pixel shows another part of the frame after the region moved, blending
+            // with the old probabilities would leave a ghost of the person
+            if (region != m_filterRegion) {
+                m_temporalFilter.Reset();
+                m_filterRegion = region;
+            }
+            m_temporalFilter.Filter(image.data(), mask.data(), imageWidth, imageHeight,
+                                    channels);
+        }
+    }
+
+    m_copiedBytes = m_input.Size() + static_cast<size_t>(imageWidth) * imageHeight;
+}
+
+auto Segmenter::ResetTemporalFilter() -> void {
+    m_temporalFilter.Allocate(m_width, m_height);
+    m_filterRegion = RegionTracker::kFullFrame;
+}
+
+auto Segmenter::CopiedBytes() const -> size_t {
+    return m_copiedBytes;
+}
+
+auto Segmenter::RecentInvokeTime() const -> float {
+    return m_recentInvokeTime.load(std::memory_order_relaxed);
+}
+
+auto Segmenter::WarmUp() -> void {
+    using clock = std::chrono::steady_clock;
+
+    // A mid-gray frame normalized like a camera frame, so 8-bit inputs get their quantized gray
+    // instead of a zero byte. The output is thrown away.
+    const std::vector<uint8_t> gray(static_cast<size_t>(m_width) * m_height * 3, 128);
+    m_preprocess(gray.data(), m_width, m_height, m_input.Data(), m_width, m_height, m_mean,
+                 m_stddev, m_inputQuantization);
+
+    const auto start = clock::now();
+    const auto status = m_pInterpreter->Invoke();
+    const auto end = clock::now();
+
+    LOGI("Warm-up invoke %s in %.2f ms\n", status == kTfLiteOk ? "done" : "failed",
+         std::chrono::duration<double, std::milli>(end - start).count());
+}
+
+auto Segmenter::Invoke() -> void {
+    using clock = std::chrono::steady_clock;
+
+    const auto start = clock::now();
+    {
+        TRACE_SCOPE("Invoke");
+        if (m_pInterpreter->Invoke() != kTfLiteOk) {
+            LOGE("Interpreter invoke failed.\n");
+        }
+    }
+    const auto end = clock::now();
+
+    const auto invokeTime = std::chrono::duration_cast<std::chrono::microseconds>(
+            end - start).count();
+    m_invokeCount++;
+    m_invokeTime += invokeTime;
+
+    // Only the worker writes, so the load and the store need not be one atomic operation
+    const auto milliseconds = static_cast<float>(invokeTime) / 1000.0f;
+    const auto recent = m_recentInvokeTime.load(std::memory_order_relaxed);
+    m_recentInvokeTime.store(m_invokeCount == 1 ? milliseconds :
+                             recent + kRecentInvokeWeight * (milliseconds - recent),
+                             std::memory_order_relaxed);
+
+    // Logged once instead of every frame, the log itself would skew the render loop
+    if (m_invokeCount == 1) {
+        LOGI("First invoke time %.2f ms\n", static_cast<double>(m_invokeTime) / 1000.0);
+    } else if (m_invokeCount == kLatencyLogInvokes) {
+        LOGI("Mean invoke time %.2f ms over %" PRIu64 " invokes\n",
+             static_cast<double>(m_invokeTime) / 1000.0 / static_cast<double>(m_invokeCount),
+             m_invokeCount);
+    }
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "AlignedBuffer.h"
+#include "InferenceOptions.h"
+#include "ModelFile.h"
+#include "ModelRegistry.h"
+#include "RegionTracker.h"
+#include "TensorFormat.h"
+#include "TemporalFilter.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <tensorflow/lite/interpreter.h>
+#include <tensorflow/lite/model_builder.h>
+
+// Runs a segmentation model described by a ModelDescriptor on 3-channel images that fit into the
+// model input, see ResizeImageToFit. Float32, float16, uint8 and int8 input and output tensors
+// are supported, the matching pre/post-processing kernels are picked at initialization. Has no
+// dependency on Android or OpenGL ES.
+class Segmenter {
+public:
+    Segmenter();
+
+    ~Segmenter();
+
+    // Keeps the model file alive as long as the interpreter. Fails when the tensors do not match
+    // the descriptor. Can be called again to switch models, the previous one is released first.
+    auto Initialize(std::unique_ptr<ModelFile> pModelFile, const ModelDescriptor &model,
+                    const InferenceOptions &options) -> bool;
+
+    auto Width() const -> int32_t;
+
+    auto Height() const -> int32_t;
+
+    // Produces a single-channel soft mask of the same size as the image, see QuantizeMask. The
+    // image has 3 channels, or 4 for RGBA readbacks whose alpha channel is ignored. region is
+    // the part of the frame the image shows, the temporal filter starts over when it changes.
+    auto Segment(const std::vector<uint8_t> &image, int32_t imageWidth, int32_t imageHeight,
+                 int32_t channels, const MaskRegion &region, std::vector<uint8_t> &mask) -> void;
+
+    // Sizes the temporal filter for the model and drops its history, call whenever the stream
+    // changes. Segment() smooths the probabilities over time once this has been called.
+    auto ResetTemporalFilter() -> void;
+
+    // Bytes the last Segment() call wrote into the input tensor and the mask.
+    auto CopiedBytes() const -> size_t;
+
+    // Exponential moving average of the invoke time in milliseconds, 0 before the first
+    // Segment() call. Safe to call from any thread.
+    auto RecentInvokeTime() const -> float;
+
+private:
+    using PreprocessFunction = void (*)(const uint8_t *image, int32_t imageWidth,
+                                        int32_t imageHeight, void *input, int32_t modelWidth,
+                                        int32_t modelHeight, float mean, float stddev,
+                                        const Quantization &quantization);
+    using PostprocessFunction = void (*)(const void *output, int32_t modelWidth,
+                                         int32_t modelHeight, uint8_t *mask, int32_t imageWidth,
+                                         int32_t imageHeight, const Quantization &quantization,
+                                         const OutputChannel &channel);
+
+    auto CheckTensors(const ModelDescriptor &model) const -> bool;
+
+    auto SelectKernels() -> bool;
+
+    auto ApplyXnnpack(const ModelDescriptor &model, const InferenceOptions &options) -> bool;
+
+    auto WarmUp() -> void;
+
+    auto Invoke() -> void;
+
+    std::unique_ptr<ModelFile> m_pModelFile;
+    std::unique_ptr<tflite::FlatBufferModel> m_pModel;
+    // Declared before the interpreter, which has to be destroyed first
+    std::unique_ptr<TfLiteDelegate, void (*)(TfLiteDelegate *)> m_pDelegate;
+    // The delegate keeps a pointer to the path
+    std::string m_weightCachePath;
+    std::unique_ptr<tflite::Interpreter> m_pInterpreter;
+
+    // Input and output tensors live in these buffers instead of the interpreter's arena
+    AlignedBuffer m_input;
+    AlignedBuffer m_output;
+
+    PreprocessFunction m_preprocess;
+    PreprocessFunction m_preprocessRgba;
+    PostprocessFunction m_postprocess;
+    Quantization m_inputQuantization;
+    Quantization m_outputQuantization;
+    OutputChannel m_outputChannel;
+    float m_mean;
+    float m_stddev;
+
+    TemporalFilter m_temporalFilter;
+    // Region of the frame the filter history covers
+    MaskRegion m_filterRegion;
+
+    int32_t m_width;
+    int32_t m_height;
+    size_t m_copiedBytes;
+    uint64_t m_invokeCount;
+    int64_t m_invokeTime;
+    std::atomic<float> m_recentInvokeTime;
+};
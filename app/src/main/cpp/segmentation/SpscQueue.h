@@ -0,0 +1,87 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Lock-free bounded queue for exactly one producer and one consumer thread. Slots are preallocated
+// and filled in place: the producer writes into Back() and publishes it with Push(), the consumer
+// reads Front() and recycles it with Pop().
+template<typename T, size_t Capacity>
+class SpscQueue {
+public:
+    SpscQueue() : m_slots(), m_head(0), m_tail(0) {
+    }
+
+    // Producer side, returns nullptr when the queue is full
+    auto Back() -> T * {
+        auto tail = m_tail.load(std::memory_order_relaxed);
+        if (Next(tail) == m_head.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &m_slots[tail];
+    }
+
+    auto Push() -> void {
+        auto tail = m_tail.load(std::memory_order_relaxed);
+        m_tail.store(Next(tail), std::memory_order_release);
+    }
+
+    // Consumer side, returns nullptr when the queue is empty
+    auto Front() -> T * {
+        auto head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &m_slots[head];
+    }
+
+    auto Pop() -> void {
+        auto head = m_head.load(std::memory_order_relaxed);
+        m_head.store(Next(head), std::memory_order_release);
+    }
+
+    auto Size() const -> size_t {
+        auto head = m_head.load(std::memory_order_acquire);
+        auto tail = m_tail.load(std::memory_order_acquire);
+        return (tail + kSlotCount - head) % kSlotCount;
+    }
+
+    // Only safe while neither the producer nor the consumer is running
+    auto Slots() -> std::array<T, Capacity + 1> & {
+        return m_slots;
+    }
+
+    auto Clear() -> void {
+        m_head.store(0, std::memory_order_relaxed);
+        m_tail.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    // One slot always stays empty to tell a full queue from an empty one
+    static constexpr size_t kSlotCount = Capacity + 1;
+
+    static auto Next(size_t index) -> size_t {
+        return (index + 1) % kSlotCount;
+    }
+
+    std::array<T, kSlotCount> m_slots;
+    alignas(64) std::atomic<size_t> m_head;
+    alignas(64) std::atomic<size_t> m_tail;
+};
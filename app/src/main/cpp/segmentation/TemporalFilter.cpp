@@ -0,0 +1,107 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TemporalFilter.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+// Sensor noise stays around 0.01 of the channel range, which keeps the weight low, while a
+// moving edge easily exceeds 0.05 and takes the new probability as is
+static constexpr float kDefaultStaticWeight = 0.2f;
+static constexpr float kDefaultMotionGain = 16.0f;
+
+TemporalFilter::TemporalFilter()
+        : m_staticWeight(kDefaultStaticWeight),
+          m_motionGain(kDefaultMotionGain),
+          m_capacity(0),
+          m_width(0),
+          m_height(0),
+          m_channels(0),
+          m_hasHistory(false) {
+}
+
+// Plain loop without branches, the compiler vectorizes it for a constant channel count
+template<int32_t Channels>
+static auto Smooth(const uint8_t *image, const uint8_t *previousImage, uint8_t *mask,
+                   float *previousProbabilities, size_t pixelCount, float staticWeight,
+                   float gain) -> void {
+    for (size_t i = 0; i < pixelCount; i++) {
+        auto difference = std::abs(image[i * Channels] - previousImage[i * Channels]) +
+                          std::abs(image[i * Channels + 1] - previousImage[i * Channels + 1]) +
+                          std::abs(image[i * Channels + 2] - previousImage[i * Channels + 2]);
+        auto weight = std::min(staticWeight + static_cast<float>(difference) * gain, 1.0f);
+
+        auto previous = previousProbabilities[i];
+        auto probability = previous + weight * (static_cast<float>(mask[i]) - previous);
+        previousProbabilities[i] = probability;
+        mask[i] = static_cast<uint8_t>(probability + 0.5f);
+    }
+}
+
+auto TemporalFilter::Allocate(int32_t width, int32_t height) -> void {
+    m_capacity = static_cast<size_t>(width) * height;
+    m_previousImage.Allocate(m_capacity * 4);
+    m_previousProbabilities.Allocate(m_capacity * sizeof(float));
+
+    Reset();
+}
+
+auto TemporalFilter::IsAllocated() const -> bool {
+    return m_previousProbabilities.Data() != nullptr;
+}
+
+auto TemporalFilter::Reset() -> void {
+    m_hasHistory = false;
+}
+
+auto TemporalFilter::SetResponse(float staticWeight, float motionGain) -> void {
+    m_staticWeight = staticWeight;
+    m_motionGain = motionGain;
+}
+
+auto TemporalFilter::Filter(const uint8_t *image, uint8_t *mask, int32_t width, int32_t height,
+                            int32_t channels) -> void {
+    auto pixelCount = static_cast<size_t>(width) * height;
+    if (pixelCount > m_capacity) {
+        return;
+    }
+
+    auto previousImage = m_previousImage.As<uint8_t>();
+    auto previousProbabilities = m_previousProbabilities.As<float>();
+
+    if (m_hasHistory && width == m_width && height == m_height && channels == m_channels) {
+        const auto gain = m_motionGain * (1.0f / (3.0f * 255.0f));
+        if (channels == 4) {
+            Smooth<4>(image, previousImage, mask, previousProbabilities, pixelCount,
+                      m_staticWeight, gain);
+        } else {
+            Smooth<3>(image, previousImage, mask, previousProbabilities, pixelCount,
+                      m_staticWeight, gain);
+        }
+    } else {
+        for (size_t i = 0; i < pixelCount; i++) {
+            previousProbabilities[i] = static_cast<float>(mask[i]);
+        }
+    }
+
+    memcpy(previousImage, image, pixelCount * channels);
+    m_width = width;
+    m_height = height;
+    m_channels = channels;
+    m_hasHistory = true;
+}
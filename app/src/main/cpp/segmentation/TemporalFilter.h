@@ -0,0 +1,62 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "AlignedBuffer.h"
+
+#include <cstdint>
+
+// Motion-adaptive exponential smoothing of the person probabilities between consecutive
+// inferences. Every pixel moves towards the new probability by a weight that grows with the
+// difference between the current and the previous image at that pixel, so static areas are
+// smoothed heavily and moving areas follow the new mask within a frame or two. Runs on the image
+// the model saw and its mask, which are never larger than the model, after QuantizeMask, so it
+// does not depend on the tensor types. The smoothed probabilities are kept in float.
+class TemporalFilter {
+public:
+    TemporalFilter();
+
+    // Preallocates the state for images of up to width x height pixels and drops the history.
+    auto Allocate(int32_t width, int32_t height) -> void;
+
+    auto IsAllocated() const -> bool;
+
+    // Forgets the previous frame, the next Filter() call passes its mask through.
+    auto Reset() -> void;
+
+    // staticWeight is the blend weight of the new probability where nothing moves, every unit of
+    // the mean absolute channel difference, in [0, 1], adds motionGain to it.
+    auto SetResponse(float staticWeight, float motionGain) -> void;
+
+    // image is the RGB or RGBA image the mask was computed from, with 3 or 4 channels, alpha is
+    // ignored. The mask is smoothed in place. A size or channel count change drops the history.
+    auto Filter(const uint8_t *image, uint8_t *mask, int32_t width, int32_t height,
+                int32_t channels) -> void;
+
+private:
+    float m_staticWeight;
+    float m_motionGain;
+
+    size_t m_capacity;
+    int32_t m_width;
+    int32_t m_height;
+    int32_t m_channels;
+    bool m_hasHistory;
+
+    AlignedBuffer m_previousImage;
+    AlignedBuffer m_previousProbabilities;
+};
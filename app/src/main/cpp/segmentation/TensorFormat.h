@@ -0,0 +1,101 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// IEEE 754 half precision value of a float16 tensor, kept as raw bits since C++17 has no portable
+// half type.
+struct Half {
+    uint16_t bits;
+};
+
+// Affine quantization of an 8-bit tensor: real = scale * (quantized - zeroPoint). Float tensors
+// use the identity.
+struct Quantization {
+    float scale = 1.0f;
+    int32_t zeroPoint = 0;
+};
+
+// Where the person probability is in a model output with channelCount interleaved channels.
+// invert marks outputs where the channel holds the background probability instead.
+struct OutputChannel {
+    int32_t channelCount = 1;
+    int32_t personChannel = 0;
+    bool invert = false;
+};
+
+// Round to nearest even, overflow goes to infinity.
+inline auto HalfFromFloat(float value) -> Half {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    const auto sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    uint32_t half;
+    if (bits >= (127u + 16u) << 23) {
+        // Too large for half precision, infinity or NaN
+        half = bits > 0x7f800000u ? 0x7e00u : 0x7c00u;
+    } else if (bits < 113u << 23) {
+        // Subnormal or zero, let the FPU do the rounding by adding a magic denormal
+        const uint32_t magicBits = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+        float magic;
+        memcpy(&magic, &magicBits, sizeof(magic));
+        float shifted;
+        memcpy(&shifted, &bits, sizeof(shifted));
+        shifted += magic;
+        memcpy(&half, &shifted, sizeof(half));
+        half -= magicBits;
+    } else {
+        const auto mantissaOdd = (bits >> 13) & 1u;
+        bits += ((15u - 127u) << 23) + 0xfffu + mantissaOdd;
+        half = bits >> 13;
+    }
+
+    return {static_cast<uint16_t>(half | (sign >> 16))};
+}
+
+inline auto FloatFromHalf(Half value) -> float {
+    const uint32_t shiftedExponent = 0x7c00u << 13;
+
+    uint32_t bits = (value.bits & 0x7fffu) << 13;
+    const auto exponent = bits & shiftedExponent;
+    bits += (127u - 15u) << 23;
+
+    if (exponent == shiftedExponent) {
+        // Infinity or NaN
+        bits += (128u - 16u) << 23;
+    } else if (exponent == 0) {
+        // Subnormal, renormalize through the FPU
+        const uint32_t magicBits = 113u << 23;
+        float magic;
+        memcpy(&magic, &magicBits, sizeof(magic));
+        bits += 1u << 23;
+        float renormalized;
+        memcpy(&renormalized, &bits, sizeof(renormalized));
+        renormalized -= magic;
+        memcpy(&bits, &renormalized, sizeof(bits));
+    }
+
+    bits |= static_cast<uint32_t>(value.bits & 0x8000u) << 16;
+
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
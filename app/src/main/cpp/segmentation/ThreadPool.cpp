@@ -0,0 +1,119 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <utility>
+
+ThreadPool::ThreadPool(int32_t threadCount)
+        : m_pTask(nullptr),
+          m_count(0),
+          m_generation(0),
+          m_pending(0),
+          m_running(false) {
+    Resize(threadCount);
+}
+
+ThreadPool::~ThreadPool() {
+    Stop();
+}
+
+auto ThreadPool::Resize(int32_t threadCount) -> void {
+    Stop();
+
+    m_running = true;
+    for (int32_t i = 1; i < std::max(threadCount, 1); i++) {
+        m_threads.emplace_back(&ThreadPool::Run, this, i, m_generation);
+    }
+}
+
+auto ThreadPool::ThreadCount() const -> int32_t {
+    return static_cast<int32_t>(m_threads.size()) + 1;
+}
+
+// Range of the index-th of threadCount threads, the first ones get one item more
+static auto Range(int32_t count, int32_t threadCount,
+                  int32_t index) -> std::pair<int32_t, int32_t> {
+    const auto size = count / threadCount;
+    const auto remainder = count % threadCount;
+    const auto begin = index * size + std::min(index, remainder);
+    return {begin, begin + size + (index < remainder ? 1 : 0)};
+}
+
+auto ThreadPool::ParallelFor(int32_t count, const Task &task) -> void {
+    const auto threadCount = ThreadCount();
+    if (threadCount == 1 || count < threadCount) {
+        task(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pTask = &task;
+        m_count = count;
+        m_pending = threadCount - 1;
+        m_generation++;
+    }
+    m_start.notify_all();
+
+    auto [begin, end] = Range(count, threadCount, 0);
+    task(begin, end);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_pending == 0; });
+    m_pTask = nullptr;
+}
+
+auto ThreadPool::Run(int32_t index, uint64_t generation) -> void {
+    while (true) {
+        const Task *pTask;
+        int32_t count;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [this, generation] {
+                return !m_running || m_generation != generation;
+            });
+            if (!m_running) {
+                return;
+            }
+            generation = m_generation;
+            pTask = m_pTask;
+            count = m_count;
+        }
+
+        auto [begin, end] = Range(count, ThreadCount(), index);
+        (*pTask)(begin, end);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending--;
+        }
+        m_done.notify_one();
+    }
+}
+
+auto ThreadPool::Stop() -> void {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_start.notify_all();
+    for (auto &thread: m_threads) {
+        thread.join();
+    }
+    m_threads.clear();
+}
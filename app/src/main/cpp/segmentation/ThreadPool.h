@@ -0,0 +1,65 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of threads for data-parallel loops over image rows. The calling thread takes part in
+// every loop, so a pool of one thread runs everything inline without any synchronization.
+class ThreadPool {
+public:
+    using Task = std::function<void(int32_t begin, int32_t end)>;
+
+    // threadCount includes the calling thread.
+    explicit ThreadPool(int32_t threadCount = 1);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    auto operator=(const ThreadPool &) -> ThreadPool & = delete;
+
+    // Joins the current threads and starts threadCount - 1 new ones.
+    auto Resize(int32_t threadCount) -> void;
+
+    auto ThreadCount() const -> int32_t;
+
+    // Splits [0, count) into one contiguous range per thread and returns when all of them have
+    // been processed. Not reentrant.
+    auto ParallelFor(int32_t count, const Task &task) -> void;
+
+private:
+    // generation is the last loop the thread must not run
+    auto Run(int32_t index, uint64_t generation) -> void;
+
+    auto Stop() -> void;
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    const Task *m_pTask;
+    int32_t m_count;
+    uint64_t m_generation;
+    int32_t m_pending;
+    bool m_running;
+};
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Trace.h"
+
+#include "Log.h"
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+
+static_assert((Tracer::kCapacity & (Tracer::kCapacity - 1)) == 0, "capacity must be a power of 2");
+
+static auto CurrentThreadId() -> uint32_t {
+    static thread_local const auto threadId = static_cast<uint32_t>(syscall(SYS_gettid));
+    return threadId;
+}
+
+Tracer Tracer::s_instance;
+
+auto Tracer::SetEnabled(bool enabled) -> void {
+    m_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+auto Tracer::Record(const char *name, int64_t start, int64_t end) -> void {
+    // Every writer owns its slot through the ticket, the sequence tells readers whether the slot
+    // holds a complete span
+    const auto index = m_next.fetch_add(1, std::memory_order_relaxed);
+    auto &event = m_events[index & (kCapacity - 1)];
+
+    event.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    event.name.store(name, std::memory_order_relaxed);
+    event.start.store(start, std::memory_order_relaxed);
+    event.end.store(end, std::memory_order_relaxed);
+    event.threadId.store(CurrentThreadId(), std::memory_order_relaxed);
+    event.sequence.store(index + 1, std::memory_order_release);
+}
+
+auto Tracer::Clear() -> void {
+    for (auto &event: m_events) {
+        event.sequence.store(0, std::memory_order_relaxed);
+    }
+    m_next.store(0, std::memory_order_relaxed);
+}
+
+auto Tracer::WriteChromeTrace(const std::string &path) const -> bool {
+    auto file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        LOGE("Could not open %s for the trace\n", path.c_str());
+        return false;
+    }
+
+    const auto next = m_next.load(std::memory_order_acquire);
+    const auto first = next > kCapacity ? next - kCapacity : 0;
+    const auto pid = static_cast<int>(getpid());
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    auto count = 0;
+    for (auto index = first; index < next; index++) {
+        const auto &event = m_events[index & (kCapacity - 1)];
+
+        // Read the span like a seqlock: it is valid only if the slot held it before and after
+        if (event.sequence.load(std::memory_order_acquire) != index + 1) {
+            continue;
+        }
+        const auto name = event.name.load(std::memory_order_relaxed);
+        const auto start = event.start.load(std::memory_order_relaxed);
+        const auto end = event.end.load(std::memory_order_relaxed);
+        const auto threadId = event.threadId.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (event.sequence.load(std::memory_order_relaxed) != index + 1) {
+            continue;
+        }
+
+        // Complete events, timestamps in microseconds
+        fprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                      "\"pid\":%d,\"tid\":%" PRIu32 "}",
+                count == 0 ? "" : ",", name, static_cast<double>(start) / 1000.0,
+                static_cast<double>(end - start) / 1000.0, pid, threadId);
+        count++;
+    }
+    fprintf(file, "\n]}\n");
+
+    const auto written = ferror(file) == 0;
+    fclose(file);
+
+    LOGI("Wrote %d trace event(s) to %s\n", count, path.c_str());
+    return written;
+}
+
+auto Tracer::Now() -> int64_t {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
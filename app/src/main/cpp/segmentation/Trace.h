@@ -0,0 +1,133 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef __ANDROID__
+#include <android/trace.h>
+#endif
+
+// Records named time spans of the pipeline stages into a fixed-size ring, from any thread and
+// without locks, for export as Chrome trace JSON (chrome://tracing, ui.perfetto.dev). Disabled by
+// default. Spans around GL calls measure the CPU side only, the GPU runs them asynchronously.
+class Tracer {
+public:
+    // Power of two, the oldest spans are overwritten once the ring is full
+    static constexpr size_t kCapacity = 8192;
+
+    static auto Instance() -> Tracer & {
+        return s_instance;
+    }
+
+    auto SetEnabled(bool enabled) -> void;
+
+    auto IsEnabled() const -> bool {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    // name has to outlive the tracer, e.g. a string literal. Times are in steady clock
+    // nanoseconds, see Now().
+    auto Record(const char *name, int64_t start, int64_t end) -> void;
+
+    // Drops all recorded spans.
+    auto Clear() -> void;
+
+    // Writes the spans in the ring as Chrome trace JSON. Spans recorded concurrently may be
+    // missing from the file, they are never torn.
+    auto WriteChromeTrace(const std::string &path) const -> bool;
+
+    static auto Now() -> int64_t;
+
+private:
+    struct Event {
+        // Index + 1 of the span the slot holds, 0 while it is being written
+        std::atomic<uint64_t> sequence;
+        std::atomic<const char *> name;
+        std::atomic<int64_t> start;
+        std::atomic<int64_t> end;
+        std::atomic<uint32_t> threadId;
+    };
+
+    // constexpr, so the instance is initialized before any dynamic initializer may trace
+    constexpr Tracer()
+            : m_enabled(false),
+              m_next(0),
+              m_events() {
+    }
+
+    static Tracer s_instance;
+
+    std::atomic<bool> m_enabled;
+    alignas(64) std::atomic<uint64_t> m_next;
+    std::array<Event, kCapacity> m_events;
+};
+
+// Records the span from construction to destruction under name, a string literal, into the Tracer
+// ring while it is enabled. On Android the span is also an ATrace section while systrace or
+// Perfetto captures the app, whether the ring is enabled or not. Inline, so with both off a scope
+// costs a relaxed atomic load and, on Android, an ATrace_isEnabled() call.
+class ScopedTrace {
+public:
+    explicit ScopedTrace(const char *name)
+            : m_name(name),
+              m_start(Tracer::Instance().IsEnabled() ? Tracer::Now() : 0),
+              m_systemTrace(IsSystemTraceEnabled()) {
+#ifdef __ANDROID__
+        if (m_systemTrace) {
+            ATrace_beginSection(name);
+        }
+#endif
+    }
+
+    ~ScopedTrace() {
+        if (m_start != 0) {
+            Tracer::Instance().Record(m_name, m_start, Tracer::Now());
+        }
+#ifdef __ANDROID__
+        if (m_systemTrace) {
+            ATrace_endSection();
+        }
+#endif
+    }
+
+    ScopedTrace(const ScopedTrace &) = delete;
+
+    auto operator=(const ScopedTrace &) -> ScopedTrace & = delete;
+
+private:
+    static auto IsSystemTraceEnabled() -> bool {
+#ifdef __ANDROID__
+        return ATrace_isEnabled();
+#else
+        return false;
+#endif
+    }
+
+    const char *m_name;
+    // 0 when the ring was disabled at construction
+    int64_t m_start;
+    bool m_systemTrace;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) ScopedTrace TRACE_CONCAT(traceScope, __LINE__)(name)
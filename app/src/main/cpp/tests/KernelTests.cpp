@@ -0,0 +1,355 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Checks every SIMD kernel of the segmentation core against its scalar reference. Sizes are odd
+// so that every kernel runs its vector loop and its tail. Results may differ where the kernels
+// round differently, each check states its tolerance. Runs the variant the dispatch picks on the
+// build machine: AVX2 or SSE2 on x86-64, NEON on ARM.
+
+#include "Compositor.h"
+#include "MaskRefiner.h"
+#include "Postprocess.h"
+#include "Preprocess.h"
+#include "TensorFormat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+static int32_t g_failures = 0;
+
+static auto RandomBytes(size_t size, uint32_t seed) -> std::vector<uint8_t> {
+    std::mt19937 generator(seed);
+    std::vector<uint8_t> bytes(size);
+    for (auto &byte: bytes) {
+        byte = static_cast<uint8_t>(generator());
+    }
+    return bytes;
+}
+
+static auto ToFloat(float value) -> float {
+    return value;
+}
+
+static auto ToFloat(Half value) -> float {
+    return FloatFromHalf(value);
+}
+
+static auto ToFloat(uint8_t value) -> float {
+    return value;
+}
+
+static auto ToFloat(int8_t value) -> float {
+    return value;
+}
+
+// Reports the first element where actual and expected differ by more than tolerance
+template<typename T>
+static auto Expect(const std::string &name, const std::vector<T> &actual,
+                   const std::vector<T> &expected, float tolerance) -> void {
+    auto maxDifference = 0.0f;
+    for (size_t i = 0; i < expected.size(); i++) {
+        const auto difference = std::fabs(ToFloat(actual[i]) - ToFloat(expected[i]));
+        if (!(difference <= tolerance)) {
+            printf("FAIL %s: element %zu is %g, expected %g, tolerance %g\n", name.c_str(), i,
+                   ToFloat(actual[i]), ToFloat(expected[i]), tolerance);
+            g_failures++;
+            return;
+        }
+        maxDifference = std::max(maxDifference, difference);
+    }
+    printf("ok   %s, max difference %g\n", name.c_str(), maxDifference);
+}
+
+struct Size {
+    int32_t width;
+    int32_t height;
+};
+
+static auto Name(const std::string &kernel, Size from, const char *relation, Size to)
+        -> std::string {
+    return kernel + " " + std::to_string(from.width) + "x" + std::to_string(from.height) + " " +
+           relation + " " + std::to_string(to.width) + "x" + std::to_string(to.height);
+}
+
+// Padded on the right and at the bottom, padded on both sides, and no padding at all
+static const Size kImageSizes[] = {{37, 23}, {45, 31}, {63, 41}};
+static const Size kModelSizes[] = {{64, 48}, {53, 31}, {63, 41}};
+
+// Float outputs may use a fused multiply-add, 8-bit outputs may round the other way at .5
+template<typename T>
+static auto NormalizeTolerance() -> float {
+    return sizeof(T) == 1 ? 1.0f : 1e-5f;
+}
+
+template<typename T>
+static auto TestPadAndNormalize(const char *type, const Quantization &quantization) -> void {
+    for (size_t i = 0; i < std::size(kImageSizes); i++) {
+        const auto image = kImageSizes[i];
+        const auto model = kModelSizes[i];
+        const auto elements = static_cast<size_t>(model.width) * model.height * 3;
+        const auto rgb = RandomBytes(static_cast<size_t>(image.width) * image.height * 3, 1);
+        const auto rgba = RandomBytes(static_cast<size_t>(image.width) * image.height * 4, 2);
+
+        std::vector<T> actual(elements);
+        std::vector<T> expected(elements);
+        PadAndNormalize(rgb.data(), image.width, image.height, actual.data(), model.width,
+                        model.height, 127.5f, 127.5f, quantization);
+        PadAndNormalizeScalar(rgb.data(), image.width, image.height, expected.data(),
+                              model.width, model.height, 127.5f, 127.5f, quantization);
+        Expect(Name(std::string("PadAndNormalize/") + type, image, "in", model), actual,
+               expected, NormalizeTolerance<T>());
+
+        PadAndNormalizeRgba(rgba.data(), image.width, image.height, actual.data(), model.width,
+                            model.height, 127.5f, 127.5f, quantization);
+        PadAndNormalizeRgbaScalar(rgba.data(), image.width, image.height, expected.data(),
+                                  model.width, model.height, 127.5f, 127.5f, quantization);
+        Expect(Name(std::string("PadAndNormalizeRgba/") + type, image, "in", model), actual,
+               expected, NormalizeTolerance<T>());
+    }
+}
+
+template<typename T>
+static auto RandomProbabilities(size_t size) -> std::vector<T> {
+    std::mt19937 generator(3);
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+    std::vector<T> probabilities(size);
+    for (auto &probability: probabilities) {
+        if constexpr (std::is_same_v<T, float>) {
+            probability = distribution(generator);
+        } else if constexpr (std::is_same_v<T, Half>) {
+            probability = HalfFromFloat(distribution(generator));
+        } else {
+            probability = static_cast<T>(generator());
+        }
+    }
+    return probabilities;
+}
+
+// The 8-bit mask may round the other way at .5
+template<typename T>
+static auto TestQuantizeMask(const char *type, const Quantization &quantization,
+                             const OutputChannel &channel) -> void {
+    for (size_t i = 0; i < std::size(kImageSizes); i++) {
+        const auto image = kImageSizes[i];
+        const auto model = kModelSizes[i];
+        const auto probabilities = RandomProbabilities<T>(
+                static_cast<size_t>(model.width) * model.height * channel.channelCount);
+
+        std::vector<uint8_t> actual(static_cast<size_t>(image.width) * image.height);
+        std::vector<uint8_t> expected(actual.size());
+        QuantizeMask(probabilities.data(), model.width, model.height, actual.data(),
+                     image.width, image.height, quantization, channel);
+        QuantizeMaskScalar(probabilities.data(), model.width, model.height, expected.data(),
+                           image.width, image.height, quantization, channel);
+        Expect(Name(std::string("QuantizeMask/") + type, model, "to", image), actual,
+               expected, 1.0f);
+    }
+}
+
+// Frame sizes from smaller than the mask up to several times larger, the mask has odd sizes
+static const Size kFrameSizes[] = {{29, 17}, {97, 55}, {211, 119}};
+static const Size kMaskSize = {37, 23};
+
+// Transcription of RefineMask of the mix shader for a mask covering the whole frame: texture
+// samples are bilinear and clamp to the edge. Within half a mask texel of the border the shader
+// blends in the edge texel under the guide of a position outside the mask, there the position is
+// clamped to the edge texel centers like MaskRefiner does.
+static auto RefineLikeShader(const std::vector<uint8_t> &guide, Size frame,
+                             const std::vector<uint8_t> &mask, Size maskSize,
+                             float rangeScale) -> std::vector<uint8_t> {
+    const auto sampleLuma = [&](double u, double v) {
+        const auto x = std::min(std::max(u * frame.width - 0.5, 0.0), frame.width - 1.0);
+        const auto y = std::min(std::max(v * frame.height - 0.5, 0.0), frame.height - 1.0);
+        const auto x0 = static_cast<int32_t>(x);
+        const auto y0 = static_cast<int32_t>(y);
+        const int32_t xs[2] = {x0, std::min(x0 + 1, frame.width - 1)};
+        const int32_t ys[2] = {y0, std::min(y0 + 1, frame.height - 1)};
+        auto luma = 0.0;
+        for (int k = 0; k < 4; k++) {
+            const auto pixel = &guide[(static_cast<size_t>(ys[k / 2]) * frame.width +
+                                       xs[k % 2]) * 4];
+            const auto weight = (k % 2 ? x - x0 : 1.0 - (x - x0)) *
+                                (k / 2 ? y - y0 : 1.0 - (y - y0));
+            luma += weight * (0.299 * pixel[0] + 0.587 * pixel[1] + 0.114 * pixel[2]) / 255.0;
+        }
+        return luma;
+    };
+
+    std::vector<uint8_t> output(static_cast<size_t>(frame.width) * frame.height);
+    for (int32_t y = 0; y < frame.height; y++) {
+        for (int32_t x = 0; x < frame.width; x++) {
+            const auto u = (x + 0.5) / frame.width;
+            const auto v = (y + 0.5) / frame.height;
+            const auto texelX = std::min(std::max(u * maskSize.width - 0.5, 0.0),
+                                         maskSize.width - 1.0);
+            const auto texelY = std::min(std::max(v * maskSize.height - 0.5, 0.0),
+                                         maskSize.height - 1.0);
+            const auto baseX = std::floor(texelX);
+            const auto baseY = std::floor(texelY);
+            const auto luma = sampleLuma(u, v);
+
+            auto numerator = 0.0;
+            auto denominator = 0.0;
+            for (int k = 0; k < 4; k++) {
+                const auto column = baseX + k % 2;
+                const auto row = baseY + k / 2;
+                const auto difference = luma - sampleLuma((column + 0.5) / maskSize.width,
+                                                          (row + 0.5) / maskSize.height);
+                const auto bilinear = (k % 2 ? texelX - baseX : 1.0 - (texelX - baseX)) *
+                                      (k / 2 ? texelY - baseY : 1.0 - (texelY - baseY));
+                const auto weight = bilinear / (1.0 + difference * difference * rangeScale);
+                const auto maskX = std::min(std::max(static_cast<int32_t>(column), 0),
+                                            maskSize.width - 1);
+                const auto maskY = std::min(std::max(static_cast<int32_t>(row), 0),
+                                            maskSize.height - 1);
+                numerator += weight * mask[maskY * maskSize.width + maskX] / 255.0;
+                denominator += weight;
+            }
+            output[y * frame.width + x] = static_cast<uint8_t>(numerator / denominator * 255.0 +
+                                                               0.5);
+        }
+    }
+    return output;
+}
+
+// Both paths blend in float, the vectorized one may sum in another order. The scalar one is also
+// checked against the mix shader, which it matches up to float rounding.
+static auto TestRefine() -> void {
+    const auto mask = RandomBytes(static_cast<size_t>(kMaskSize.width) * kMaskSize.height, 4);
+    for (auto frame: kFrameSizes) {
+        const auto guide = RandomBytes(static_cast<size_t>(frame.width) * frame.height * 4, 6);
+        std::vector<uint8_t> actual(static_cast<size_t>(frame.width) * frame.height);
+        std::vector<uint8_t> expected(actual.size());
+
+        MaskRefiner refiner;
+        refiner.SetRangeSigma(0.1f);
+        refiner.Refine(guide.data(), frame.width, frame.height, mask.data(), kMaskSize.width,
+                       kMaskSize.height, actual.data());
+        refiner.RefineScalar(guide.data(), frame.width, frame.height, mask.data(),
+                             kMaskSize.width, kMaskSize.height, expected.data());
+        Expect(Name("MaskRefiner", kMaskSize, "to", frame), actual, expected, 1.0f);
+
+        const auto shader = RefineLikeShader(guide, frame, mask, kMaskSize, 100.0f);
+        Expect(Name("MaskRefiner/shader", kMaskSize, "to", frame), expected, shader, 1.0f);
+    }
+}
+
+// The compositor samples the mask and blends in 1/256 fixed point, the reference in float
+static auto TestComposite() -> void {
+    const auto mask = RandomBytes(static_cast<size_t>(kMaskSize.width) * kMaskSize.height, 7);
+    for (auto frameSize: kFrameSizes) {
+        const auto pixels = static_cast<size_t>(frameSize.width) * frameSize.height;
+        const auto frame = RandomBytes(pixels * 4, 8);
+        const auto background = RandomBytes(pixels * 4, 9);
+        std::vector<uint8_t> expected(pixels * 4);
+        Compositor::CompositeScalar(frame.data(), background.data(), mask.data(),
+                                    kMaskSize.width, kMaskSize.height, expected.data(),
+                                    frameSize.width, frameSize.height);
+
+        for (auto threadCount: {1, 3}) {
+            std::vector<uint8_t> actual(pixels * 4);
+            Compositor compositor(threadCount);
+            compositor.Composite(frame.data(), background.data(), mask.data(), kMaskSize.width,
+                                 kMaskSize.height, actual.data(), frameSize.width,
+                                 frameSize.height);
+            const auto name = "Compositor/" + std::to_string(threadCount) + "t";
+            Expect(Name(name, kMaskSize, "to", frameSize), actual, expected, 2.0f);
+        }
+    }
+}
+
+static auto ExpectHalf(const char *name, float value, uint16_t bits) -> void {
+    const auto half = HalfFromFloat(value);
+    if (half.bits != bits) {
+        printf("FAIL HalfFromFloat(%s) is 0x%04x, expected 0x%04x\n", name, half.bits, bits);
+        g_failures++;
+    }
+}
+
+// Every finite half and infinity converts to float and back to the same bits, NaN stays NaN.
+// Conversions from float round to nearest even, including into the subnormal range.
+static auto TestHalf() -> void {
+    auto failures = g_failures;
+    for (uint32_t bits = 0; bits <= 0xffffu; bits++) {
+        const Half half = {static_cast<uint16_t>(bits)};
+        const auto value = FloatFromHalf(half);
+        const auto roundTrip = HalfFromFloat(value).bits;
+        const auto isNan = (bits & 0x7c00u) == 0x7c00u && (bits & 0x03ffu) != 0;
+        if (isNan ? !std::isnan(value) || (roundTrip & 0x7fffu) <= 0x7c00u : roundTrip != bits) {
+            printf("FAIL half 0x%04x converts to %g and back to 0x%04x\n", bits, value,
+                   roundTrip);
+            g_failures++;
+            break;
+        }
+    }
+
+    const auto smallestSubnormal = std::ldexp(1.0f, -24);
+    ExpectHalf("smallest subnormal", smallestSubnormal, 0x0001u);
+    ExpectHalf("half the smallest subnormal", smallestSubnormal * 0.5f, 0x0000u);
+    ExpectHalf("1.5 smallest subnormals", smallestSubnormal * 1.5f, 0x0002u);
+    ExpectHalf("largest subnormal", std::ldexp(1023.0f, -24), 0x03ffu);
+    ExpectHalf("smallest normal", std::ldexp(1.0f, -14), 0x0400u);
+    ExpectHalf("-0", -0.0f, 0x8000u);
+    ExpectHalf("1", 1.0f, 0x3c00u);
+    ExpectHalf("largest finite", 65504.0f, 0x7bffu);
+    ExpectHalf("rounding to infinity", 65520.0f, 0x7c00u);
+    ExpectHalf("infinity", INFINITY, 0x7c00u);
+    ExpectHalf("-infinity", -INFINITY, 0xfc00u);
+    if (FloatFromHalf({0x0001u}) != smallestSubnormal || FloatFromHalf({0x7c00u}) != INFINITY) {
+        printf("FAIL FloatFromHalf of the smallest subnormal or infinity\n");
+        g_failures++;
+    }
+
+    if (g_failures == failures) {
+        printf("ok   Half conversions\n");
+    }
+}
+
+int main() {
+    const Quantization uint8Quantization = {1.0f / 128.0f, 128};
+    const Quantization int8Quantization = {1.0f / 128.0f, 0};
+    TestPadAndNormalize<float>("float", {});
+    TestPadAndNormalize<Half>("half", {});
+    TestPadAndNormalize<uint8_t>("uint8", uint8Quantization);
+    TestPadAndNormalize<int8_t>("int8", int8Quantization);
+
+    // 8-bit probabilities
+    const Quantization maskQuantization = {1.0f / 255.0f, 0};
+    const Quantization int8MaskQuantization = {1.0f / 256.0f, -128};
+    TestQuantizeMask<float>("float", {}, {});
+    TestQuantizeMask<Half>("half", {}, {});
+    TestQuantizeMask<uint8_t>("uint8", maskQuantization, {});
+    TestQuantizeMask<int8_t>("int8", int8MaskQuantization, {});
+    TestQuantizeMask<float>("multiclass", {}, {6, 0, true});
+    TestQuantizeMask<float>("multiclass/person", {}, {3, 1, false});
+
+    TestRefine();
+    TestComposite();
+    TestHalf();
+
+    if (g_failures > 0) {
+        printf("%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    return 0;
+}
@@ -51,6 +51,16 @@ build_one() {
     echo "==> Copied libtensorflowlite.so for $cpu"
 }
 
+# Host build used by the desktop Linux segmentation core (see segmentation/CMakeLists.txt)
+build_linux() {
+    echo "==> Building TFLite for linux-x86_64"
+    bazel build -c opt //tensorflow/lite:tensorflowlite
+    mkdir -p "/output/linux-x86_64"
+    cp "./bazel-bin/tensorflow/lite/libtensorflowlite.so" \
+       "/output/linux-x86_64/libtensorflowlite.so"
+    echo "==> Copied libtensorflowlite.so for linux-x86_64"
+}
+
 ARM64_FLAGS="--define xnn_enable_arm_i8mm=false --linkopt=-Wl,-z,max-page-size=16384 --linkopt=-Wl,-z,common-page-size=16384"
 ARM_FLAGS="--define xnn_enable_arm_i8mm=false"
 X86_64_FLAGS="--define=xnn_enable_avxvnni=false --define=xnn_enable_avxvnniint8=false --define=xnn_enable_avx512amx=false --define=xnn_enable_avx512fp16=false --linkopt=-Wl,-z,max-page-size=16384 --linkopt=-Wl,-z,common-page-size=16384"
@@ -61,6 +71,7 @@ case "$TARGET_ARCH" in
     armeabi-v7a) build_one "arm"    "armeabi-v7a" "$ARM_FLAGS" ;;
     x86_64)      build_one "x86_64" "x86_64"      "$X86_64_FLAGS" ;;
     x86)         build_one "x86"    "x86"         "$X86_FLAGS" ;;
+    linux-x86_64) build_linux ;;
     all)
         build_one "arm64"  "arm64-v8a"   "$ARM64_FLAGS"
         build_one "arm"    "armeabi-v7a" "$ARM_FLAGS"
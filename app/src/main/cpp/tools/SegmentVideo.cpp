@@ -0,0 +1,329 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BoundedQueue.h"
+#include "Compositor.h"
+#include "ImageUtils.h"
+#include "ModelRegistry.h"
+#include "RegionTracker.h"
+#include "Segmenter.h"
+#include "Trace.h"
+#include "VideoIO.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Frames in flight across the three stages, every queue holds at most this many
+static constexpr size_t kQueueCapacity = 4;
+
+struct Options {
+    std::string input;
+    std::string output;
+    std::string background;
+    std::string assets = "app/src/main/assets";
+    std::string modelName = "square";
+    std::string modelFile;
+    std::string tracePath;
+    int32_t rawWidth = 0;
+    int32_t rawHeight = 0;
+    int32_t threadCount = 2;
+    int32_t compositeThreadCount = 2;
+    int64_t maxFrames = -1;
+};
+
+// A frame travels decode -> infer -> composite and returns to the pool afterwards
+struct Frame {
+    uint64_t index;
+    std::vector<uint8_t> rgba;
+    std::vector<uint8_t> image;
+    std::vector<uint8_t> mask;
+    int64_t decodeStart;
+};
+
+using FrameQueue = BoundedQueue<std::unique_ptr<Frame>>;
+
+// Latencies of one stage in nanoseconds, only touched by the thread running the stage
+class StageStats {
+public:
+    explicit StageStats(const char *name) : m_name(name) {
+    }
+
+    auto Add(int64_t start, int64_t end) -> void {
+        m_samples.push_back(end - start);
+    }
+
+    auto Print() -> void {
+        if (m_samples.empty()) {
+            return;
+        }
+        std::sort(m_samples.begin(), m_samples.end());
+        double sum = 0.0;
+        for (auto sample: m_samples) {
+            sum += static_cast<double>(sample);
+        }
+        const auto percentile = [this](double fraction) {
+            auto index = static_cast<size_t>(fraction * static_cast<double>(m_samples.size() - 1));
+            return static_cast<double>(m_samples[index]) / 1e6;
+        };
+        fprintf(stderr, "%-12s %10.2f %10.2f %10.2f %10.2f\n", m_name,
+                sum / static_cast<double>(m_samples.size()) / 1e6, percentile(0.5),
+                percentile(0.95), static_cast<double>(m_samples.back()) / 1e6);
+    }
+
+private:
+    const char *m_name;
+    std::vector<int64_t> m_samples;
+};
+
+static auto Usage(const char *program) -> int {
+    fprintf(stderr,
+            "Usage: %s [options] <input> <output.y4m>\n"
+            "Replaces the background of a person in a video, \"-\" reads stdin or writes stdout.\n"
+            "  --background=<file.ppm>  background image, binary PPM, required\n"
+            "  --raw=<width>x<height>   input is headerless rgb24 frames instead of Y4M\n"
+            "  --assets=<dir>           model assets, default app/src/main/assets\n"
+            "  --model=<name>           registry model, default square\n"
+            "  --model-file=<file>      .tflite file, default <assets>/<model path>\n"
+            "  --threads=<count>        interpreter threads, default 2\n"
+            "  --composite-threads=<count>  compositor threads, default 2\n"
+            "  --frames=<count>         stop after this many frames\n"
+            "  --trace=<file.json>      write a Chrome trace of the stages\n", program);
+    return 1;
+}
+
+static auto ParseOptions(int argc, char **argv, Options &options) -> bool {
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--background=", 13) == 0) {
+            options.background = argv[i] + 13;
+        } else if (strncmp(argv[i], "--raw=", 6) == 0) {
+            if (sscanf(argv[i] + 6, "%dx%d", &options.rawWidth, &options.rawHeight) != 2) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "--assets=", 9) == 0) {
+            options.assets = argv[i] + 9;
+        } else if (strncmp(argv[i], "--model=", 8) == 0) {
+            options.modelName = argv[i] + 8;
+        } else if (strncmp(argv[i], "--model-file=", 13) == 0) {
+            options.modelFile = argv[i] + 13;
+        } else if (strncmp(argv[i], "--threads=", 10) == 0) {
+            options.threadCount = atoi(argv[i] + 10);
+        } else if (strncmp(argv[i], "--composite-threads=", 20) == 0) {
+            options.compositeThreadCount = atoi(argv[i] + 20);
+        } else if (strncmp(argv[i], "--frames=", 9) == 0) {
+            options.maxFrames = atoll(argv[i] + 9);
+        } else if (strncmp(argv[i], "--trace=", 8) == 0) {
+            options.tracePath = argv[i] + 8;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            return false;
+        } else {
+            files.emplace_back(argv[i]);
+        }
+    }
+
+    if (files.size() != 2 || options.background.empty()) {
+        return false;
+    }
+    options.input = files[0];
+    options.output = files[1];
+    return true;
+}
+
+int main(int argc, char **argv) {
+    using clock = std::chrono::steady_clock;
+
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        return Usage(argv[0]);
+    }
+
+    auto pModel = FindModel(options.modelName.c_str());
+    if (pModel == nullptr) {
+        fprintf(stderr, "Unknown model %s\n", options.modelName.c_str());
+        return 1;
+    }
+    if (options.modelFile.empty()) {
+        options.modelFile = options.assets + "/" + pModel->path;
+    }
+
+    auto pModelFile = std::make_unique<ModelFile>();
+    InferenceOptions inferenceOptions;
+    inferenceOptions.threadCount = options.threadCount;
+    Segmenter segmenter;
+    if (!pModelFile->Map(options.modelFile.c_str()) ||
+        !segmenter.Initialize(std::move(pModelFile), *pModel, inferenceOptions)) {
+        fprintf(stderr, "Could not load model %s\n", options.modelFile.c_str());
+        return 1;
+    }
+
+    VideoReader reader;
+    auto opened = options.rawWidth > 0 ?
+                  reader.OpenRaw(options.input, options.rawWidth, options.rawHeight) :
+                  reader.OpenY4m(options.input);
+    if (!opened) {
+        return 1;
+    }
+    const auto width = reader.Width();
+    const auto height = reader.Height();
+
+    std::vector<uint8_t> backgroundImage;
+    int32_t backgroundWidth = 0;
+    int32_t backgroundHeight = 0;
+    if (!LoadPpm(options.background, backgroundImage, backgroundWidth, backgroundHeight)) {
+        return 1;
+    }
+    std::vector<uint8_t> background(static_cast<size_t>(width) * height * 4);
+    ResizeBilinear(backgroundImage.data(), backgroundWidth, backgroundHeight, 3,
+                   background.data(), width, height, 4);
+
+    Y4mWriter writer;
+    if (!writer.Open(options.output, width, height, reader.FrameRateNumerator(),
+                     reader.FrameRateDenominator())) {
+        return 1;
+    }
+
+    auto [imageWidth, imageHeight] = ResizeImageToFit(width, height, segmenter.Width(),
+                                                      segmenter.Height());
+    segmenter.ResetTemporalFilter();
+
+    if (!options.tracePath.empty()) {
+        Tracer::Instance().SetEnabled(true);
+    }
+
+    // Every frame buffer is allocated once and recycled through the pool
+    FrameQueue pool(kQueueCapacity * 3);
+    FrameQueue inferQueue(kQueueCapacity);
+    FrameQueue compositeQueue(kQueueCapacity);
+    for (size_t i = 0; i < kQueueCapacity * 3; i++) {
+        auto frame = std::make_unique<Frame>();
+        frame->rgba.resize(static_cast<size_t>(width) * height * 4);
+        frame->image.resize(static_cast<size_t>(imageWidth) * imageHeight * 3);
+        frame->mask.resize(static_cast<size_t>(imageWidth) * imageHeight);
+        pool.Push(std::move(frame));
+    }
+
+    StageStats decodeStats("decode");
+    StageStats inferStats("segment");
+    StageStats compositeStats("composite");
+    StageStats encodeStats("encode");
+    StageStats endToEndStats("end-to-end");
+    uint64_t frameCount = 0;
+    auto failed = false;
+
+    const auto start = clock::now();
+
+    std::thread decoder([&] {
+        std::unique_ptr<Frame> frame;
+        for (uint64_t index = 0; options.maxFrames < 0 ||
+                                 static_cast<int64_t>(index) < options.maxFrames; index++) {
+            if (!pool.Pop(frame)) {
+                break;
+            }
+
+            TRACE_SCOPE("Decode");
+            frame->index = index;
+            frame->decodeStart = Tracer::Now();
+            if (!reader.Read(frame->rgba)) {
+                break;
+            }
+            ResizeBilinear(frame->rgba.data(), width, height, 4, frame->image.data(), imageWidth,
+                           imageHeight, 3);
+            decodeStats.Add(frame->decodeStart, Tracer::Now());
+
+            if (!inferQueue.Push(std::move(frame))) {
+                break;
+            }
+        }
+        inferQueue.Close();
+    });
+
+    std::thread inferrer([&] {
+        std::unique_ptr<Frame> frame;
+        while (inferQueue.Pop(frame)) {
+            const auto inferStart = Tracer::Now();
+            segmenter.Segment(frame->image, imageWidth, imageHeight, 3, RegionTracker::kFullFrame,
+                              frame->mask);
+            inferStats.Add(inferStart, Tracer::Now());
+
+            if (!compositeQueue.Push(std::move(frame))) {
+                break;
+            }
+        }
+        compositeQueue.Close();
+    });
+
+    // Compositing and encoding run on the main thread, the compositor splits rows over its own
+    // threads
+    Compositor compositor(options.compositeThreadCount);
+    std::unique_ptr<Frame> frame;
+    while (compositeQueue.Pop(frame)) {
+        const auto compositeStart = Tracer::Now();
+        {
+            TRACE_SCOPE("Composite");
+            compositor.Composite(frame->rgba.data(), background.data(), frame->mask.data(),
+                                 imageWidth, imageHeight, frame->rgba.data(), width, height);
+        }
+        const auto compositeEnd = Tracer::Now();
+        compositeStats.Add(compositeStart, compositeEnd);
+
+        {
+            TRACE_SCOPE("Encode");
+            failed = !writer.Write(frame->rgba);
+        }
+        const auto encodeEnd = Tracer::Now();
+        encodeStats.Add(compositeEnd, encodeEnd);
+        endToEndStats.Add(frame->decodeStart, encodeEnd);
+        frameCount++;
+
+        if (failed) {
+            fprintf(stderr, "Could not write frame %llu\n",
+                    static_cast<unsigned long long>(frame->index));
+            break;
+        }
+        pool.Push(std::move(frame));
+    }
+
+    // Unblock the other stages if the loop above stopped early
+    pool.Close();
+    inferQueue.Close();
+    compositeQueue.Close();
+    decoder.join();
+    inferrer.join();
+
+    const auto seconds = std::chrono::duration<double>(clock::now() - start).count();
+    fprintf(stderr, "%llu frame(s) of %dx%d in %.2f s, %.1f fps, model %s %dx%d\n",
+            static_cast<unsigned long long>(frameCount), width, height, seconds,
+            static_cast<double>(frameCount) / seconds, pModel->name, segmenter.Width(),
+            segmenter.Height());
+    fprintf(stderr, "%-12s %10s %10s %10s %10s\n", "Stage (ms)", "mean", "p50", "p95", "max");
+    decodeStats.Print();
+    inferStats.Print();
+    compositeStats.Print();
+    encodeStats.Print();
+    endToEndStats.Print();
+
+    if (!options.tracePath.empty()) {
+        Tracer::Instance().WriteChromeTrace(options.tracePath);
+    }
+
+    return failed ? 1 : 0;
+}
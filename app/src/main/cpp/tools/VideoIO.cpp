@@ -0,0 +1,381 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VideoIO.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+
+// BT.601 limited range, the usual colorimetry of Y4M streams, in 8.8 fixed point
+static auto Clamp(int32_t value) -> uint8_t {
+    return static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+}
+
+static auto YuvToRgba(int32_t y, int32_t u, int32_t v, uint8_t *rgba) -> void {
+    const auto c = 298 * (y - 16) + 128;
+    const auto d = u - 128;
+    const auto e = v - 128;
+    rgba[0] = Clamp((c + 409 * e) >> 8);
+    rgba[1] = Clamp((c - 100 * d - 208 * e) >> 8);
+    rgba[2] = Clamp((c + 516 * d) >> 8);
+    rgba[3] = 255;
+}
+
+static auto RgbToY(const uint8_t *rgb) -> uint8_t {
+    return static_cast<uint8_t>(((66 * rgb[0] + 129 * rgb[1] + 25 * rgb[2] + 128) >> 8) + 16);
+}
+
+// r, g and b are sums over count pixels
+static auto RgbToUv(int32_t r, int32_t g, int32_t b, int32_t count, uint8_t &u,
+                    uint8_t &v) -> void {
+    const auto scale = 1.0f / (256.0f * static_cast<float>(count));
+    u = Clamp(static_cast<int32_t>(lroundf((-38 * r - 74 * g + 112 * b) * scale)) + 128);
+    v = Clamp(static_cast<int32_t>(lroundf((112 * r - 94 * g - 18 * b) * scale)) + 128);
+}
+
+static auto OpenFile(const std::string &path, const char *mode) -> FILE * {
+    if (path == "-") {
+        return mode[0] == 'r' ? stdin : stdout;
+    }
+    auto file = fopen(path.c_str(), mode);
+    if (file == nullptr) {
+        fprintf(stderr, "Could not open %s\n", path.c_str());
+    }
+    return file;
+}
+
+static auto CloseFile(FILE *file) -> void {
+    if (file != nullptr && file != stdin && file != stdout) {
+        fclose(file);
+    } else if (file == stdout) {
+        fflush(file);
+    }
+}
+
+// Reads up to and excluding the next newline, false at the end of the stream
+static auto ReadLine(FILE *file, std::string &line) -> bool {
+    line.clear();
+    for (auto c = fgetc(file); c != '\n'; c = fgetc(file)) {
+        if (c == EOF) {
+            return false;
+        }
+        line.push_back(static_cast<char>(c));
+    }
+    return true;
+}
+
+VideoReader::VideoReader()
+        : m_file(nullptr),
+          m_y4m(false),
+          m_chroma444(false),
+          m_width(0),
+          m_height(0),
+          m_frameRateNumerator(30),
+          m_frameRateDenominator(1) {
+}
+
+VideoReader::~VideoReader() {
+    CloseFile(m_file);
+}
+
+auto VideoReader::Open(const std::string &path) -> bool {
+    CloseFile(m_file);
+    m_file = OpenFile(path, "rb");
+    return m_file != nullptr;
+}
+
+auto VideoReader::OpenY4m(const std::string &path) -> bool {
+    if (!Open(path)) {
+        return false;
+    }
+
+    std::string header;
+    if (!ReadLine(m_file, header) || header.compare(0, 10, "YUV4MPEG2 ") != 0) {
+        fprintf(stderr, "%s is not a YUV4MPEG2 stream\n", path.c_str());
+        return false;
+    }
+
+    m_y4m = true;
+    m_chroma444 = false;
+    size_t position = 10;
+    while (position < header.size()) {
+        auto end = header.find(' ', position);
+        if (end == std::string::npos) {
+            end = header.size();
+        }
+        const auto token = header.substr(position, end - position);
+        position = end + 1;
+        if (token.empty()) {
+            continue;
+        }
+
+        const auto value = token.substr(1);
+        switch (token[0]) {
+            case 'W':
+                m_width = atoi(value.c_str());
+                break;
+            case 'H':
+                m_height = atoi(value.c_str());
+                break;
+            case 'F':
+                sscanf(value.c_str(), "%d:%d", &m_frameRateNumerator, &m_frameRateDenominator);
+                break;
+            case 'C':
+                // 420jpeg, 420mpeg2, 420paldv and plain 420 share the plane layout
+                if (value.compare(0, 3, "444") == 0 && value.size() == 3) {
+                    m_chroma444 = true;
+                } else if (value.compare(0, 3, "420") != 0) {
+                    fprintf(stderr, "Unsupported Y4M chroma format %s\n", value.c_str());
+                    return false;
+                }
+                break;
+            default:
+                // Interlacing, aspect ratio and extensions do not matter here
+                break;
+        }
+    }
+
+    if (m_width <= 0 || m_height <= 0 || m_frameRateNumerator <= 0 ||
+        m_frameRateDenominator <= 0) {
+        fprintf(stderr, "Invalid Y4M header: %s\n", header.c_str());
+        return false;
+    }
+
+    const auto lumaSize = static_cast<size_t>(m_width) * m_height;
+    const auto chromaSize = m_chroma444 ? lumaSize : static_cast<size_t>((m_width + 1) / 2) *
+                                                     ((m_height + 1) / 2);
+    m_planes.resize(lumaSize + 2 * chromaSize);
+    return true;
+}
+
+auto VideoReader::OpenRaw(const std::string &path, int32_t width, int32_t height) -> bool {
+    if (width <= 0 || height <= 0 || !Open(path)) {
+        return false;
+    }
+
+    m_y4m = false;
+    m_width = width;
+    m_height = height;
+    m_frameRateNumerator = 30;
+    m_frameRateDenominator = 1;
+    return true;
+}
+
+auto VideoReader::Read(std::vector<uint8_t> &rgba) -> bool {
+    const auto pixels = static_cast<size_t>(m_width) * m_height;
+    rgba.resize(pixels * 4);
+
+    if (!m_y4m) {
+        // rgb24 frames are read into the front of the buffer and spread out backwards in place
+        if (fread(rgba.data(), 1, pixels * 3, m_file) != pixels * 3) {
+            return false;
+        }
+        for (auto i = pixels; i-- > 0;) {
+            rgba[i * 4 + 3] = 255;
+            rgba[i * 4 + 2] = rgba[i * 3 + 2];
+            rgba[i * 4 + 1] = rgba[i * 3 + 1];
+            rgba[i * 4] = rgba[i * 3];
+        }
+        return true;
+    }
+
+    std::string frameHeader;
+    if (!ReadLine(m_file, frameHeader) || frameHeader.compare(0, 5, "FRAME") != 0 ||
+        fread(m_planes.data(), 1, m_planes.size(), m_file) != m_planes.size()) {
+        return false;
+    }
+
+    const auto luma = m_planes.data();
+    const auto chromaWidth = m_chroma444 ? m_width : (m_width + 1) / 2;
+    const auto chromaSize = (m_planes.size() - pixels) / 2;
+    const auto cb = luma + pixels;
+    const auto cr = cb + chromaSize;
+    const auto shift = m_chroma444 ? 0 : 1;
+
+    for (int32_t y = 0; y < m_height; y++) {
+        const auto chromaRow = static_cast<size_t>(y >> shift) * chromaWidth;
+        auto dst = rgba.data() + static_cast<size_t>(y) * m_width * 4;
+        for (int32_t x = 0; x < m_width; x++) {
+            const auto chroma = chromaRow + (x >> shift);
+            YuvToRgba(luma[static_cast<size_t>(y) * m_width + x], cb[chroma], cr[chroma],
+                      dst + x * 4);
+        }
+    }
+    return true;
+}
+
+auto VideoReader::Width() const -> int32_t {
+    return m_width;
+}
+
+auto VideoReader::Height() const -> int32_t {
+    return m_height;
+}
+
+auto VideoReader::FrameRateNumerator() const -> int32_t {
+    return m_frameRateNumerator;
+}
+
+auto VideoReader::FrameRateDenominator() const -> int32_t {
+    return m_frameRateDenominator;
+}
+
+Y4mWriter::Y4mWriter()
+        : m_file(nullptr),
+          m_width(0),
+          m_height(0) {
+}
+
+Y4mWriter::~Y4mWriter() {
+    CloseFile(m_file);
+}
+
+auto Y4mWriter::Open(const std::string &path, int32_t width, int32_t height,
+                     int32_t frameRateNumerator, int32_t frameRateDenominator) -> bool {
+    CloseFile(m_file);
+    m_file = OpenFile(path, "wb");
+    if (m_file == nullptr) {
+        return false;
+    }
+
+    m_width = width;
+    m_height = height;
+    const auto chromaSize = static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2);
+    m_planes.resize(static_cast<size_t>(width) * height + 2 * chromaSize);
+
+    return fprintf(m_file, "YUV4MPEG2 W%d H%d F%d:%d Ip A1:1 C420jpeg\n", width, height,
+                   frameRateNumerator, frameRateDenominator) > 0;
+}
+
+auto Y4mWriter::Write(const std::vector<uint8_t> &rgba) -> bool {
+    const auto pixels = static_cast<size_t>(m_width) * m_height;
+    const auto chromaWidth = (m_width + 1) / 2;
+    const auto chromaHeight = (m_height + 1) / 2;
+    const auto cb = m_planes.data() + pixels;
+    const auto cr = cb + static_cast<size_t>(chromaWidth) * chromaHeight;
+
+    for (size_t i = 0; i < pixels; i++) {
+        m_planes[i] = RgbToY(rgba.data() + i * 4);
+    }
+
+    // Chroma of every 2x2 block from the mean of its pixels, edges of odd sizes average fewer
+    for (int32_t y = 0; y < chromaHeight; y++) {
+        for (int32_t x = 0; x < chromaWidth; x++) {
+            int32_t r = 0;
+            int32_t g = 0;
+            int32_t b = 0;
+            int32_t count = 0;
+            for (auto sy = y * 2; sy < std::min(y * 2 + 2, m_height); sy++) {
+                for (auto sx = x * 2; sx < std::min(x * 2 + 2, m_width); sx++) {
+                    const auto pixel = rgba.data() + (static_cast<size_t>(sy) * m_width + sx) * 4;
+                    r += pixel[0];
+                    g += pixel[1];
+                    b += pixel[2];
+                    count++;
+                }
+            }
+            const auto index = static_cast<size_t>(y) * chromaWidth + x;
+            RgbToUv(r, g, b, count, cb[index], cr[index]);
+        }
+    }
+
+    return fputs("FRAME\n", m_file) >= 0 &&
+           fwrite(m_planes.data(), 1, m_planes.size(), m_file) == m_planes.size();
+}
+
+// Skips whitespace and comments between the fields of a PPM header
+static auto ReadPpmField(FILE *file, int32_t &value) -> bool {
+    auto c = fgetc(file);
+    while (c == '#' || isspace(c)) {
+        if (c == '#') {
+            while (c != '\n' && c != EOF) {
+                c = fgetc(file);
+            }
+        }
+        c = fgetc(file);
+    }
+    ungetc(c, file);
+    return fscanf(file, "%d", &value) == 1;
+}
+
+auto LoadPpm(const std::string &path, std::vector<uint8_t> &rgb, int32_t &width,
+             int32_t &height) -> bool {
+    auto file = OpenFile(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    char magic[2] = {};
+    int32_t maxValue = 0;
+    auto loaded = fread(magic, 1, 2, file) == 2 && magic[0] == 'P' && magic[1] == '6' &&
+                  ReadPpmField(file, width) && ReadPpmField(file, height) &&
+                  ReadPpmField(file, maxValue) && maxValue == 255 && width > 0 && height > 0 &&
+                  isspace(fgetc(file));
+    if (loaded) {
+        rgb.resize(static_cast<size_t>(width) * height * 3);
+        loaded = fread(rgb.data(), 1, rgb.size(), file) == rgb.size();
+    }
+
+    if (!loaded) {
+        fprintf(stderr, "%s is not a binary PPM image with 8-bit channels\n", path.c_str());
+    }
+    CloseFile(file);
+    return loaded;
+}
+
+auto ResizeBilinear(const uint8_t *src, int32_t srcWidth, int32_t srcHeight, int32_t srcChannels,
+                    uint8_t *dst, int32_t dstWidth, int32_t dstHeight,
+                    int32_t dstChannels) -> void {
+    const auto scaleX = static_cast<float>(srcWidth) / static_cast<float>(dstWidth);
+    const auto scaleY = static_cast<float>(srcHeight) / static_cast<float>(dstHeight);
+
+    // Horizontal taps are the same for every row
+    std::vector<int32_t> left(dstWidth);
+    std::vector<float> weights(dstWidth);
+    for (int32_t x = 0; x < dstWidth; x++) {
+        const auto sx = std::max((static_cast<float>(x) + 0.5f) * scaleX - 0.5f, 0.0f);
+        left[x] = std::min(static_cast<int32_t>(sx), srcWidth - 1);
+        weights[x] = sx - static_cast<float>(left[x]);
+    }
+
+    for (int32_t y = 0; y < dstHeight; y++) {
+        const auto sy = std::max((static_cast<float>(y) + 0.5f) * scaleY - 0.5f, 0.0f);
+        const auto top = std::min(static_cast<int32_t>(sy), srcHeight - 1);
+        const auto bottom = std::min(top + 1, srcHeight - 1);
+        const auto wy = sy - static_cast<float>(top);
+        const auto topRow = src + static_cast<size_t>(top) * srcWidth * srcChannels;
+        const auto bottomRow = src + static_cast<size_t>(bottom) * srcWidth * srcChannels;
+        auto dstRow = dst + static_cast<size_t>(y) * dstWidth * dstChannels;
+
+        for (int32_t x = 0; x < dstWidth; x++) {
+            const auto x0 = left[x] * srcChannels;
+            const auto x1 = std::min(left[x] + 1, srcWidth - 1) * srcChannels;
+            const auto wx = weights[x];
+            for (int32_t c = 0; c < 3; c++) {
+                const auto upper = topRow[x0 + c] + wx * (topRow[x1 + c] - topRow[x0 + c]);
+                const auto lower = bottomRow[x0 + c] +
+                                   wx * (bottomRow[x1 + c] - bottomRow[x0 + c]);
+                dstRow[x * dstChannels + c] = static_cast<uint8_t>(upper + wy * (lower - upper) +
+                                                                   0.5f);
+            }
+            if (dstChannels == 4) {
+                dstRow[x * 4 + 3] = 255;
+            }
+        }
+    }
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2025 Oleg Chornenko.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Reads video frames as packed 8-bit RGBA, either from a YUV4MPEG2 (.y4m) stream with 4:2:0 or
+// 4:4:4 chroma, or from headerless rgb24 frames of a known size. "-" reads stdin.
+class VideoReader {
+public:
+    VideoReader();
+
+    ~VideoReader();
+
+    VideoReader(const VideoReader &) = delete;
+
+    auto operator=(const VideoReader &) -> VideoReader & = delete;
+
+    auto OpenY4m(const std::string &path) -> bool;
+
+    auto OpenRaw(const std::string &path, int32_t width, int32_t height) -> bool;
+
+    // Returns false at the end of the stream or on a truncated frame.
+    auto Read(std::vector<uint8_t> &rgba) -> bool;
+
+    auto Width() const -> int32_t;
+
+    auto Height() const -> int32_t;
+
+    // Frame rate as a fraction, 30:1 for raw input.
+    auto FrameRateNumerator() const -> int32_t;
+
+    auto FrameRateDenominator() const -> int32_t;
+
+private:
+    auto Open(const std::string &path) -> bool;
+
+    FILE *m_file;
+    bool m_y4m;
+    bool m_chroma444;
+    int32_t m_width;
+    int32_t m_height;
+    int32_t m_frameRateNumerator;
+    int32_t m_frameRateDenominator;
+    std::vector<uint8_t> m_planes;
+};
+
+// Writes packed 8-bit RGBA frames as a 4:2:0 YUV4MPEG2 stream, "-" writes stdout.
+class Y4mWriter {
+public:
+    Y4mWriter();
+
+    ~Y4mWriter();
+
+    Y4mWriter(const Y4mWriter &) = delete;
+
+    auto operator=(const Y4mWriter &) -> Y4mWriter & = delete;
+
+    auto Open(const std::string &path, int32_t width, int32_t height, int32_t frameRateNumerator,
+              int32_t frameRateDenominator) -> bool;
+
+    auto Write(const std::vector<uint8_t> &rgba) -> bool;
+
+private:
+    FILE *m_file;
+    int32_t m_width;
+    int32_t m_height;
+    std::vector<uint8_t> m_planes;
+};
+
+// Loads a binary PPM (P6) image with 8-bit channels as packed RGB.
+auto LoadPpm(const std::string &path, std::vector<uint8_t> &rgb, int32_t &width,
+             int32_t &height) -> bool;
+
+// Bilinear resampling of the color channels of a packed RGB or RGBA image, sampling at pixel
+// centers like GL_LINEAR. An RGBA destination gets an opaque alpha channel.
+auto ResizeBilinear(const uint8_t *src, int32_t srcWidth, int32_t srcHeight, int32_t srcChannels,
+                    uint8_t *dst, int32_t dstWidth, int32_t dstHeight,
+                    int32_t dstChannels) -> void;
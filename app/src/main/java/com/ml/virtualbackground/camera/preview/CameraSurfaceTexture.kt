@@ -42,10 +42,13 @@ class CameraSurfaceTexture(
     private val transformMatrix: FloatArray = FloatArray(16)
     private val extraTransformMatrix: FloatArray = FloatArray(16)
     private var backgroundBitmap: Bitmap? = null
+    private var pendingModel: String? = null
+    private var pendingLatencyBudget: Float? = null
 
     fun init(context: Context) {
         nativeInit(
             context.assets,
+            context.cacheDir.absolutePath,
             surfaceTexture,
             inputTexture,
             outputTexture
@@ -62,6 +65,14 @@ class CameraSurfaceTexture(
             nativeSetParams(surfaceTexture, size.width, size.height, texture)
             previewInvalidated = false
         }
+        pendingModel?.let {
+            nativeSelectModel(surfaceTexture, it)
+            pendingModel = null
+        }
+        pendingLatencyBudget?.let {
+            nativeSetLatencyBudget(surfaceTexture, it)
+            pendingLatencyBudget = null
+        }
 
         super.updateTexImage()
         getTransformMatrix(transformMatrix)
@@ -82,6 +93,17 @@ class CameraSurfaceTexture(
         previewInvalidated = true
     }
 
+    // Registry model name, see ModelRegistry.cpp. Applied with the next frame.
+    fun selectModel(name: String) {
+        pendingModel = name
+    }
+
+    // Moves to a faster model whenever inference takes longer than budgetMs, 0 turns it off.
+    // Applied with the next frame.
+    fun setLatencyBudget(budgetMs: Float) {
+        pendingLatencyBudget = budgetMs
+    }
+
     private fun updateTexture(bitmap: Bitmap, texture: Int) {
         GLES20.glBindTexture(GLES20.GL_TEXTURE_2D, texture)
 
@@ -106,6 +128,7 @@ class CameraSurfaceTexture(
 
     private external fun nativeInit(
         assetManager: AssetManager,
+        cacheDir: String,
         surfaceTexture: Long,
         inputTexture: Int,
         outputTexture: Int
@@ -124,5 +147,9 @@ class CameraSurfaceTexture(
         extraTransformMatrix: FloatArray
     )
 
+    private external fun nativeSelectModel(surfaceTexture: Long, name: String)
+
+    private external fun nativeSetLatencyBudget(surfaceTexture: Long, budgetMs: Float)
+
     private external fun nativeRelease(surfaceTexture: Long)
 }
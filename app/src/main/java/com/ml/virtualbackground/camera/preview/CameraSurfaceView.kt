@@ -57,6 +57,7 @@ class CameraSurfaceView : GLSurfaceView, GLSurfaceView.Renderer {
             ).apply {
                 setOnFrameAvailableListener { requestRender() }
                 init(context.applicationContext)
+                setLatencyBudget(LATENCY_BUDGET_MS)
                 surfaceTextureListener?.onSurfaceReady(this)
             }
         }
@@ -124,4 +125,9 @@ class CameraSurfaceView : GLSurfaceView, GLSurfaceView.Renderer {
     )
 
     private external fun nativeRelease(surfaceView: Long)
+
+    companion object {
+        // Inference slower than a frame at 30 fps switches to a faster model
+        private const val LATENCY_BUDGET_MS = 33f
+    }
 }